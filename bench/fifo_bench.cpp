@@ -0,0 +1,115 @@
+/*
+ * Copyright 2023 Davit Hakobyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares ring_fifo with ring_base on push/pop of single elements and of
+// runs of elements, and prints the storage both take. Build from the
+// repository root:
+//
+//   g++ -std=c++17 -O2 -I. bench/fifo_bench.cpp cpp_emb_lib.cpp -o fifo_bench
+
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+#include "cpp_emb_lib.hpp"
+
+namespace
+{
+    using namespace cel::buffer;
+
+    // a command of 6 bytes, which ring_base pads to 8 with its marks
+    struct cmd_t
+    {
+        std::uint16_t id;
+        std::uint16_t arg;
+        std::uint16_t crc;
+    };
+
+    constexpr ring_base::span_t ring_size = 100u;
+    constexpr ring_base::span_t run_size  = 32u;
+    constexpr std::uint32_t rounds        = 2000000u;
+
+    template <typename engine>
+    using ring_t = ring_maker<cmd_t, inline_ring_allocator<cmd_t, ring_size, engine>>;
+
+    // Returns ns per pushed and popped element
+    template <typename engine>
+    double run_single(std::uint32_t& check)
+    {
+        static ring_t<engine> ring;
+        cmd_t cmd = {};
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint32_t i = 0u; i < rounds; ++i)
+        {
+            cmd.id = static_cast<std::uint16_t>(i);
+            (void)ring.push(cmd);
+            (void)ring.pop(cmd);
+            check += cmd.id;
+        }
+
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        return elapsed.count() / rounds;
+    }
+
+    // Returns ns per element pushed and popped in runs
+    template <typename engine>
+    double run_bulk(std::uint32_t& check)
+    {
+        static ring_t<engine> ring;
+        cmd_t cmds[run_size] = {};
+
+        // keep the ring partly filled, so that runs wrap around the end of the storage
+        (void)ring.push_n(cmds, ring_size / 2u);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint32_t i = 0u; i < (rounds / run_size); ++i)
+        {
+            cmds[0].id = static_cast<std::uint16_t>(i);
+            (void)ring.push_n(cmds, run_size);
+            (void)ring.pop_n(cmds, run_size);
+            check += cmds[0].id;
+        }
+
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        return elapsed.count() / ((rounds / run_size) * run_size);
+    }
+}
+
+int main()
+{
+    std::uint32_t check = 0u;
+
+    const double ns_base = run_single<ring_base>(check);
+    const double ns_fifo = run_single<ring_fifo>(check);
+
+    const double ns_base_bulk = run_bulk<ring_base>(check);
+    const double ns_fifo_bulk = run_bulk<ring_fifo>(check);
+
+    std::printf("                       ring_base   ring_fifo\n");
+    std::printf("push+pop, ns/elem      %9.2f   %9.2f\n", ns_base, ns_fifo);
+    std::printf("push_n+pop_n, ns/elem  %9.2f   %9.2f\n", ns_base_bulk, ns_fifo_bulk);
+    std::printf("storage, bytes         %9u   %9u\n",
+                static_cast<unsigned>(cel::detail::storage_size<ring_base, cmd_t>(ring_size)),
+                static_cast<unsigned>(cel::detail::storage_size<ring_fifo, cmd_t>(ring_size)));
+    std::printf("(check %u)\n", static_cast<unsigned>(check));
+
+    return 0;
+}
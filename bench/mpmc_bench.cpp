@@ -0,0 +1,167 @@
+/*
+ * Copyright 2023 Davit Hakobyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures throughput of ring_mpmc as the number of producers and consumers
+// grows, next to ring_base serialized by a std::mutex. Build from the
+// repository root:
+//
+//   g++ -std=c++17 -O2 -I. bench/mpmc_bench.cpp cpp_emb_lib.cpp -lpthread -o mpmc_bench
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cpp_emb_lib.hpp"
+
+namespace
+{
+    using namespace cel::buffer;
+
+    constexpr ring_base::span_t ring_size = 1024u;
+    constexpr std::uint32_t total_items   = 2000000u;
+
+    using mpmc_ring_t = ring_maker<std::uint32_t, inline_ring_allocator<std::uint32_t, ring_size, ring_mpmc>>;
+    using base_ring_t = ring_maker<std::uint32_t, inline_ring_allocator<std::uint32_t, ring_size, ring_base>>;
+
+    // ring_base is not thread safe on a host, so every call takes the lock
+    class locked_ring
+    {
+    public:
+        bool push(const std::uint32_t& t)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return ring_.push(t);
+        }
+
+        bool pop(std::uint32_t& t)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return ring_.pop(t);
+        }
+
+    private:
+        std::mutex mutex_;
+        base_ring_t ring_;
+    };
+
+    // Returns millions of elements per second, or a negative value if elements were lost
+    template <typename ring_t>
+    double run(unsigned producers, unsigned consumers)
+    {
+        std::unique_ptr<ring_t> ring(new ring_t());
+
+        const std::uint32_t per_producer = total_items / producers;
+        const std::uint32_t expected = per_producer * producers;
+
+        std::atomic<std::uint32_t> popped(0u);
+        std::atomic<std::uint64_t> sum(0u);
+        std::atomic<bool> b_start(false);
+
+        std::vector<std::thread> threads;
+
+        for (unsigned p = 0u; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]()
+            {
+                while (!b_start.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+
+                for (std::uint32_t i = 0u; i < per_producer; ++i)
+                {
+                    const std::uint32_t value = p * per_producer + i;
+                    while (!ring->push(value))
+                    {
+                        // lets the consumers run when there are fewer cores than threads
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        for (unsigned c = 0u; c < consumers; ++c)
+        {
+            threads.emplace_back([&]()
+            {
+                std::uint64_t local_sum = 0u;
+                std::uint32_t value = 0u;
+
+                while (!b_start.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+
+                while (popped.load(std::memory_order_relaxed) < expected)
+                {
+                    if (ring->pop(value))
+                    {
+                        local_sum += value;
+                        popped.fetch_add(1u, std::memory_order_relaxed);
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+
+                sum.fetch_add(local_sum);
+            });
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        b_start.store(true, std::memory_order_release);
+
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        const std::uint64_t n = expected;
+        const bool b_ok = (sum.load() == (n * (n - 1u)) / 2u);
+
+        return b_ok ? (expected / elapsed.count()) : -1.0;
+    }
+}
+
+int main()
+{
+    const unsigned counts[] = { 1u, 2u, 4u };
+
+    std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    std::printf("producers consumers   ring_mpmc Mops/s   ring_base+mutex Mops/s\n");
+
+    for (unsigned producers : counts)
+    {
+        for (unsigned consumers : counts)
+        {
+            const double mops_mpmc = run<mpmc_ring_t>(producers, consumers);
+            const double mops_base = run<locked_ring>(producers, consumers);
+
+            std::printf("%9u %9u   %16.2f   %22.2f\n", producers, consumers, mops_mpmc, mops_base);
+            std::fflush(stdout);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2023 Davit Hakobyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares global operator new/delete served by cpp_emb_lib_new.cpp with
+// C malloc/free of the C runtime. Build from the repository root:
+//
+//   g++ -std=c++17 -O2 -DCEL_STATIC_HEAP_SIZE=65000u -I. bench/new_bench.cpp cpp_emb_lib.cpp cpp_emb_lib_new.cpp -lpthread -o new_bench
+//
+// Add -DCEL_NEW_POOL_CLASSES=7u -DCEL_NEW_POOL_SIZE=8192u to serve the 512 byte
+// buffers of the workload from the pools instead of the static heap.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+#include "cpp_emb_lib.hpp"
+
+namespace
+{
+    constexpr std::size_t live_count = 32u;
+    constexpr std::uint32_t rounds   = 200000u;
+
+    // sizes of small objects, e.g. list nodes, with an occasional larger buffer
+    std::size_t size_of(std::uint32_t i)
+    {
+        return (0u == (i % 16u)) ? 512u : (8u + (i % 7u) * 16u);
+    }
+
+    template <typename alloc_t, typename free_t>
+    double run(alloc_t alloc, free_t release)
+    {
+        void* live[live_count] = {};
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (std::uint32_t i = 0u; i < rounds; ++i)
+        {
+            // replace one of the live buffers, so that the heap holds a mix of sizes
+            void*& slot = live[(i * 7u) % live_count];
+            release(slot);
+            slot = alloc(size_of(i));
+        }
+
+        for (void* p : live)
+        {
+            release(p);
+        }
+
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        return elapsed.count() / rounds;
+    }
+}
+
+int main()
+{
+    const double ns_new = run([](std::size_t size) { return ::operator new(size); },
+                              [](void* p) { ::operator delete(p); });
+
+    const double ns_malloc = run([](std::size_t size) { return std::malloc(size); },
+                                 [](void* p) { std::free(p); });
+
+    std::printf("new/delete (library): %6.1f ns per pair\n", ns_new);
+    std::printf("malloc/free (libc):   %6.1f ns per pair\n", ns_malloc);
+    std::printf("static heap free:     %u bytes\n", static_cast<unsigned>(cel::buffer::static_heap::free_size()));
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2023 Davit Hakobyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares ring_spsc, which loads the other side's index on every call, with
+// ring_spsc_cached, which keeps a copy of it, with the producer and the
+// consumer pinned to two different cores. Build from the repository root:
+//
+//   g++ -std=c++17 -O2 -I. bench/spsc_bench.cpp cpp_emb_lib.cpp -lpthread -o spsc_bench
+//
+// The cores are given as arguments, 0 and 1 by default. With a single core
+// the threads are not pinned and the results say little about caching.
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include "cpp_emb_lib.hpp"
+
+namespace
+{
+    using namespace cel::buffer;
+
+    constexpr ring_base::span_t ring_size = 1024u;
+    constexpr std::uint32_t total_items   = 20000000u;
+    constexpr unsigned repeats            = 5u;
+
+    template <typename engine>
+    using ring_t = ring_maker<std::uint32_t, inline_ring_allocator<std::uint32_t, ring_size, engine>>;
+
+    // Returns true if the calling thread now runs on the core only
+    bool pin(int core)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+
+        return (0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set));
+    }
+
+    // Returns millions of elements per second, or a negative value if elements were lost
+    template <typename engine>
+    double run(int core_producer, int core_consumer, bool b_pin)
+    {
+        std::unique_ptr<ring_t<engine>> ring(new ring_t<engine>());
+
+        std::atomic<bool> b_start(false);
+        std::uint64_t sum = 0u;
+
+        std::thread consumer([&]()
+        {
+            std::uint64_t local_sum = 0u;
+            std::uint32_t value = 0u;
+
+            if (b_pin)
+            {
+                (void)pin(core_consumer);
+            }
+
+            while (!b_start.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+
+            for (std::uint32_t i = 0u; i < total_items; )
+            {
+                if (ring->pop(value))
+                {
+                    local_sum += value;
+                    ++i;
+                }
+                else if (!b_pin)
+                {
+                    // lets the producer run when both threads share the core
+                    std::this_thread::yield();
+                }
+                else
+                {
+                    // spin
+                }
+            }
+
+            sum = local_sum;
+        });
+
+        if (b_pin)
+        {
+            (void)pin(core_producer);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        b_start.store(true, std::memory_order_release);
+
+        for (std::uint32_t i = 0u; i < total_items; ++i)
+        {
+            while (!ring->push(i))
+            {
+                if (!b_pin)
+                {
+                    std::this_thread::yield();
+                }
+                else
+                {
+                    // spin
+                }
+            }
+        }
+
+        consumer.join();
+
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        const std::uint64_t n = total_items;
+        const bool b_ok = (sum == (n * (n - 1u)) / 2u);
+
+        return b_ok ? (total_items / elapsed.count()) : -1.0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const int core_producer = (argc > 1) ? std::atoi(argv[1]) : 0;
+    const int core_consumer = (argc > 2) ? std::atoi(argv[2]) : 1;
+
+    const bool b_pin = (std::thread::hardware_concurrency() > 1u) && (core_producer != core_consumer);
+
+    if (b_pin)
+    {
+        std::printf("producer on core %d, consumer on core %d\n", core_producer, core_consumer);
+    }
+    else
+    {
+        std::printf("single core, threads not pinned\n");
+    }
+
+    std::printf("run   ring_spsc Mops/s   ring_spsc_cached Mops/s\n");
+
+    for (unsigned r = 0u; r < repeats; ++r)
+    {
+        const double mops_plain  = run<ring_spsc>(core_producer, core_consumer, b_pin);
+        const double mops_cached = run<ring_spsc_cached>(core_producer, core_consumer, b_pin);
+
+        std::printf("%3u   %16.2f   %23.2f\n", r, mops_plain, mops_cached);
+        std::fflush(stdout);
+    }
+
+    return 0;
+}
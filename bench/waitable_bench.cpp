@@ -0,0 +1,157 @@
+/*
+ * Copyright 2023 Davit Hakobyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures waitable_ring over ring_mpmc with one producer and several
+// consumers sleeping in pop_wait, woken by a futex and by an eventfd. The
+// producer pauses after every burst, so that the consumers park. A pop_wait
+// timing out while elements are still pushed means a lost wake. Build from
+// the repository root:
+//
+//   g++ -std=c++17 -O2 -I. bench/waitable_bench.cpp cpp_emb_lib.cpp cpp_emb_lib_posix.cpp -lpthread -o waitable_bench
+//
+// The number of consumers is given as argument, 3 by default. Returns 1 if
+// a wake was lost or elements were lost.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "cpp_emb_lib.hpp"
+#include "cpp_emb_lib_posix.hpp"
+
+namespace
+{
+    using namespace cel::buffer;
+
+    constexpr ring_base::span_t ring_size = 256u;
+    constexpr std::uint32_t total_items   = 200000u;
+    constexpr std::uint32_t burst         = 64u;
+    constexpr std::uint32_t stop          = 0xFFFFFFFFu;
+
+    // long enough for any wake, so that a timeout means the wake was lost
+    constexpr int timeout_ms              = 1000;
+
+    template <bool b_eventfd>
+    using ring_t = waitable_ring<std::uint32_t, ring_heap_allocator<std::uint32_t, ring_mpmc>, b_eventfd>;
+
+    struct result_t
+    {
+        double mops;
+        std::uint32_t timeouts;
+        bool b_ok;
+    };
+
+    template <bool b_eventfd>
+    result_t run(unsigned consumers)
+    {
+        std::unique_ptr<ring_t<b_eventfd>> ring(new ring_t<b_eventfd>(ring_size));
+
+        std::atomic<std::uint64_t> sum(0u);
+        std::atomic<std::uint32_t> timeouts(0u);
+        std::vector<std::thread> threads;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (unsigned c = 0u; c < consumers; ++c)
+        {
+            threads.emplace_back([&]()
+            {
+                std::uint64_t local_sum = 0u;
+                std::uint32_t value = 0u;
+                bool b_run = true;
+
+                while (b_run)
+                {
+                    if ( !ring->pop_wait(value, timeout_ms) )
+                    {
+                        (void)timeouts.fetch_add(1u);
+                    }
+                    else if (stop == value)
+                    {
+                        b_run = false;
+                    }
+                    else
+                    {
+                        local_sum += value;
+                    }
+                }
+
+                (void)sum.fetch_add(local_sum);
+            });
+        }
+
+        for (std::uint32_t i = 0u; i < total_items; ++i)
+        {
+            while (!ring->push(i))
+            {
+                std::this_thread::yield();
+            }
+
+            if (0u == ((i + 1u) % burst))
+            {
+                // lets the consumers drain the ring and park
+                std::this_thread::sleep_for(std::chrono::microseconds(20));
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        for (unsigned c = 0u; c < consumers; ++c)
+        {
+            while (!ring->push(stop))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+        const std::uint64_t n = total_items;
+
+        return { total_items / elapsed.count(), timeouts.load(), (sum.load() == (n * (n - 1u)) / 2u) };
+    }
+
+    bool report(const char* name, const result_t& res)
+    {
+        std::printf("%-8s %8.2f Mops/s   timeouts %u   %s\n", name, res.mops, static_cast<unsigned>(res.timeouts), res.b_ok ? "ok" : "elements lost");
+
+        return res.b_ok && (0u == res.timeouts);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const unsigned consumers = (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : 3u;
+
+    std::printf("1 producer, %u consumers\n", consumers);
+
+    const bool b_futex   = report("futex", run<false>(consumers));
+    const bool b_eventfd = report("eventfd", run<true>(consumers));
+
+    return (b_futex && b_eventfd) ? 0 : 1;
+}
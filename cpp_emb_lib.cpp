@@ -25,29 +25,114 @@ namespace cel
         /*----------------------------------------------------------------------------*/
         /**
         *  Allocates a buffer of requested size or returns nullptr if the space is not enough
-        *  to satisfy the request.
+        *  to satisfy the request. If there is no space, the reclaim handlers are called
+        *  in order of their priority and allocation is retried after each handler which
+        *  reports released memory.
         *
         */
         void* static_heap::alloc(heap_sz_t size)
         {
-            reset();
+            void *p = alloc_page(size);
+
+            if ((nullptr == p) && (0u != size) && !b_reclaiming_)
+            {
+                // handlers may allocate themselves, but that must not trigger reclaiming again
+                b_reclaiming_ = true;
+
+                for (std::uint8_t i = 0u; (i < reclaim_count_) && (nullptr == p); ++i)
+                {
+                    if ( reclaim_[i].handler(size) )
+                    {
+                        p = alloc_page(size);
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+
+                b_reclaiming_ = false;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return p;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Registers a reclaim handler. Handlers with lower priority value are called first.
+        *  Returns false if there is no room for the handler.
+        *
+        */
+        bool static_heap::add_reclaim_handler(reclaim_handler_t handler, std::uint8_t priority)
+        {
+            bool retval = false;
 
-            // to be on a safe side lets align to 4-byte boundary
-            // instead of just making size even
-            if (0 != (size & 3))
+            if ((nullptr != handler) && (reclaim_count_ < CEL_RECLAIM_HANDLERS))
             {
-                // make requested odd sizes even
-                // ++size;
+                // keep the list sorted, handlers of equal priority are called in order of registration
+                std::uint8_t i = reclaim_count_;
+                while ((i > 0u) && (reclaim_[i - 1u].priority > priority))
+                {
+                    reclaim_[i] = reclaim_[i - 1u];
+                    --i;
+                }
 
-                size += 4 - (size & 3);
+                reclaim_[i].handler = handler;
+                reclaim_[i].priority = priority;
+                ++reclaim_count_;
+
+                retval = true;
             }
             else
             {
                 // do nothing
             }
 
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Unregisters the reclaim handler
+        *
+        */
+        void static_heap::remove_reclaim_handler(reclaim_handler_t handler)
+        {
+            std::uint8_t j = 0u;
+
+            for (std::uint8_t i = 0u; i < reclaim_count_; ++i)
+            {
+                if (reclaim_[i].handler != handler)
+                {
+                    reclaim_[j++] = reclaim_[i];
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+
+            reclaim_count_ = j;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Finds the first free page large enough for the requested size and splits it
+        *  if the remainder is large enough to hold another page.
+        *
+        */
+        void* static_heap::alloc_page(heap_sz_t size)
+        {
+            reset();
+
+            size = align_size(size);
+
             std::uint8_t *p = heap_start_;
-            if (0u == size || (free_size_ < static_cast<std::uint32_t>(size + page_size_)) )
+            if (0u == size || (free_size_ < (static_cast<std::uint32_t>(size + page_size_) + reserved_)) )
             {
                 p = heap_end_;
             }
@@ -64,6 +149,9 @@ namespace cel
                             // so do not split the available free page
                             // just mark it allocated
                             page->free = false;
+                            page->owner = 0u;
+
+                            free_size_ -= page->size;
                         }
                         else
                         {
@@ -84,6 +172,7 @@ namespace cel
 
                             page->size = size;
                             page->free = false;
+                            page->owner = 0u;
 
                             free_size_ -= size + page_size_;
                         }
@@ -117,9 +206,9 @@ namespace cel
         {
             reset();
 
-            if ((static_cast<std::uint8_t*>(p) > heap_start_) && (static_cast<std::uint8_t*>(p) < heap_end_))
+            page_t* page = page_of(p);
+            if (nullptr != page)
             {
-                page_t* page = reinterpret_cast<page_t*>(reinterpret_cast<std::uintptr_t>(p) - page_size_);
                 defragment(page);
             }
             else
@@ -128,6 +217,44 @@ namespace cel
             }
         }
 
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Frees the previously allocated buffer of known size. The size must be the one
+        *  requested at allocation. Since the caller vouches for the buffer, only the page
+        *  header is checked against the size and the heap walk of the unsized free is skipped.
+        *  A size which does not match the page is caught by ASSERT and the buffer is kept.
+        *
+        */
+        void static_heap::free(void *p, heap_sz_t size)
+        {
+            reset();
+
+            page_t* page = page_of(p);
+            if (nullptr != page)
+            {
+                size = align_size(size);
+
+                // alloc does not split a page if the remainder cannot hold a page header
+                const bool b_match = !page->free && (page->size >= size) && ((page->size - size) <= page_size_);
+
+                // a wrong size would leak the buffer unnoticed
+                ASSERT(b_match);
+
+                if (b_match)
+                {
+                    coalesce(page);
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
         /*----------------------------------------------------------------------------*/
         /**
         *  One-time initializer of the heap
@@ -154,20 +281,18 @@ namespace cel
 
         /*----------------------------------------------------------------------------*/
         /**
-        *  Defragments of free separated but continuous spaces into a larger free space.
-        *  This function is called by static_free to release the buffer pointer by pg
-        *  and to, possibly, defragment free spaces which may appear after releasing of the
-        *  current buffer.
+        *  Validates the page to be released by walking the heap and hands it over to
+        *  coalesce. This function is called by free to release the buffer pointed by pg
+        *  when the size of the buffer is not known.
         *
         */
         void static_heap::defragment(page_t * const pg)
         {
             bool bfound = false;
-            uint8_t *p = heap_start_;
+            std::uint8_t *p = heap_start_;
             page_t *page = nullptr;
 
-            // Find the last page as well as
-            // check the validity of the requested page
+            // Check the validity of the requested page
             do
             {
                 page = reinterpret_cast<page_t*>(p);
@@ -182,56 +307,296 @@ namespace cel
                     // do nothing
                 }
 
-            } while (p < heap_end_);
+            } while ((p < heap_end_) && (reinterpret_cast<std::uint8_t*>(page) < reinterpret_cast<std::uint8_t*>(pg)));
 
             if ( bfound )
             {
-                // Requested page exist, mark it as free
-                pg->free = true;
+                coalesce(pg);
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Marks the page as free and merges it with its free neighbours. Since free pages
+        *  are always merged on release, no two free pages are adjacent and it is enough to
+        *  look at the next and at the previous page only.
+        *
+        */
+        void static_heap::coalesce(page_t * const pg)
+        {
+            page_t *page = pg;
+
+            page->free = true;
+            free_size_ += page->size;
+
+            page_t *page_next = next_page(page);
+            if ((nullptr != page_next) && page_next->free)
+            {
+                // the header of the next page becomes free space too
+                page->size += page_next->size + page_size_;
+                free_size_ += page_size_;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            if ((nullptr != page->prev) && page->prev->free)
+            {
+                page->prev->size += page->size + page_size_;
+                free_size_ += page_size_;
+                page = page->prev;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            page_next = next_page(page);
+            if (nullptr != page_next)
+            {
+                page_next->prev = page;
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the smallest id not used by a living budget or 0 if all 255 ids
+        *  are taken
+        *
+        */
+        std::uint8_t heap_budget::take_id()
+        {
+            std::uint8_t id = 0u;
+
+            for (std::uint32_t i = 1u; (i < 256u) && (0u == id); ++i)
+            {
+                const std::uint32_t bit = 1u << (i % 32u);
 
-                if (free_size_ < heap_size_)
+                if (0u == (ids_used_[i / 32u] & bit))
                 {
-                    free_size_ += pg->size + page_size_;
+                    ids_used_[i / 32u] |= bit;
+                    id = static_cast<std::uint8_t>(i);
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+
+            return id;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Makes the id available to new budgets
+        *
+        */
+        void heap_budget::put_id(std::uint8_t id)
+        {
+            if (0u != id)
+            {
+                ids_used_[id / 32u] &= ~(1u << (id % 32u));
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Creates a budget and books its reservation on the heap. If there is not enough
+        *  free space for the reservation, the budget is not good but still allocates
+        *  within its ceiling without any guarantee. Only the number of reserved bytes
+        *  is booked, so an allocation within the reservation still fails if no free
+        *  page is large enough. If 255 budgets are alive, the budget gets no id, is not
+        *  good and all its allocations fail.
+        *
+        */
+        heap_budget::heap_budget(const char* name, std::uint32_t reservation, std::uint32_t ceiling) :
+                                        name_(name),
+                                        id_(take_id()),
+                                        reservation_(reservation),
+                                        ceiling_(ceiling),
+                                        used_(0u),
+                                        peak_(0u),
+                                        failures_(0u),
+                                        b_good_(false),
+                                        b_alloc_(false)
+        {
+            static_heap::reset();
+
+            if ((0u != id_) && (reservation_ <= ceiling_) && ((static_heap::free_size_ - static_heap::reserved_) >= reservation_))
+            {
+                static_heap::reserved_ += reservation_;
+                b_good_ = true;
+            }
+            else
+            {
+                reservation_ = 0u;
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the unused part of the reservation to the heap and the id to new
+        *  budgets. Buffers still allocated through the budget stay valid, but must not
+        *  be freed through a budget created later with the same id.
+        *
+        */
+        heap_budget::~heap_budget()
+        {
+            static_heap::reserved_ -= held();
+            put_id(id_);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Allocates a buffer if the ceiling allows. The unused reservation of the budget
+        *  is made available to this request only. A reclaim handler called meanwhile must
+        *  not allocate from the same budget, such a nested request fails. The heap may
+        *  hand out a page larger than requested, if it overshoots the ceiling the page is
+        *  freed and the request fails.
+        *
+        */
+        void* heap_budget::alloc(heap_sz_t size)
+        {
+            void *p = nullptr;
+
+            // the reservation is already taken out of the heap by the outer request
+            if ((0u != id_) && !b_alloc_ && ((used_ + static_heap::align_size(size) + static_heap::page_size_) <= ceiling_))
+            {
+                static_heap::reserved_ -= held();
+
+                // reclaim handlers may free buffers of this budget meanwhile
+                b_alloc_ = true;
+                p = static_heap::alloc(size);
+                b_alloc_ = false;
+                static_heap::page_t *page = (nullptr != p) ? static_heap::page_of(p) : nullptr;
+
+                // the heap may hand out a slightly larger page than requested
+                if ((nullptr != page) && ((used_ + page->size + static_heap::page_size_) > ceiling_))
+                {
+                    static_heap::free(p);
+                    p = nullptr;
                 }
                 else
                 {
                     // do nothing
                 }
 
-                // Last page found, go backward and defragment continuous free pages
-                page_t *page_busy = nullptr;
-                while (reinterpret_cast<std::uint8_t*>(page) > heap_start_)
+                if (nullptr != p)
                 {
-                    if ( !page->free )
+                    page->owner = id_;
+                    used_ += page->size + static_heap::page_size_;
+
+                    if (used_ > peak_)
                     {
-                        page_busy = page;
-                        page = page->prev;
-                        continue;
+                        peak_ = used_;
                     }
                     else
                     {
                         // do nothing
                     }
+                }
+                else
+                {
+                    // do nothing
+                }
 
-                    if (page->prev->free)
-                    {
-                        page->prev->size += page->size + page_size_;
+                static_heap::reserved_ += held();
+            }
+            else
+            {
+                // do nothing
+            }
 
-                        if (nullptr != page_busy)
-                        {
-                            page_busy->prev = page->prev;
-                        }
-                        else
-                        {
-                            // do nothing
-                        }
+            if (nullptr == p)
+            {
+                ++failures_;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return p;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Frees the buffer allocated through the budget
+        *
+        */
+        void heap_budget::free(void *p)
+        {
+            release(p, 0u, false);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Frees the buffer of known size allocated through the budget
+        *
+        */
+        void heap_budget::free(void *p, heap_sz_t size)
+        {
+            release(p, size, true);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Frees the buffer and refills the reservation if the usage drops below it.
+        *  Buffers of other budgets or of the plain heap are not released.
+        *
+        */
+        void heap_budget::release(void *p, heap_sz_t size, bool b_sized)
+        {
+            static_heap::page_t *page = static_heap::page_of(p);
+
+            // a buffer of another budget would spoil the usage of both
+            ASSERT((nullptr == page) || page->free || (id_ == page->owner));
+
+            if ((nullptr != page) && !page->free && (id_ == page->owner))
+            {
+                const std::uint32_t cost = page->size + static_heap::page_size_;
+
+                if (b_sized)
+                {
+                    static_heap::free(p, size);
+                }
+                else
+                {
+                    static_heap::free(p);
+                }
+
+                // the page header is left marked free even if merged with the previous page
+                if (page->free && (used_ >= cost))
+                {
+                    // during alloc the reservation is already taken out of the heap
+                    // and is put back by alloc itself
+                    if ( !b_alloc_ )
+                    {
+                        static_heap::reserved_ -= held();
+                        used_ -= cost;
+                        static_heap::reserved_ += held();
                     }
                     else
                     {
-                        // do nothing
+                        used_ -= cost;
                     }
-
-                    page = page->prev;
+                }
+                else
+                {
+                    // do nothing
                 }
             }
             else
@@ -302,7 +667,7 @@ namespace cel
         */
         std::uint8_t* ring_base::ptr_to_end(const ring_info& info, ring_base::endpoint pnt)
         {
-            const span_t featured_elem_size = info.elem_size + feature_size_;
+            const span_t featured_elem_size = info.stride;
 
             DISABLE_INTERRUPTS();
             std::uint8_t* ptr = endpoint::Head == pnt ? (info.ptr_buff + info.head * featured_elem_size) :
@@ -461,23 +826,181 @@ namespace cel
 
         /*----------------------------------------------------------------------------*/
         /**
-        *  Returns the oldest element of ring buffer but does not remove it from the fifo.
-        *  Only marks the element as 'visited'.
+        *  Pushes up to n_elems elements at once within a single critical section and
+        *  returns the number of pushed elements. In infinite mode the oldest elements
+        *  are discarded to make room and, if n_elems exceeds the size of the buffer, only
+        *  the newest elements are stored.
         *
         */
-        bool ring_base::read_shadow (ring_info& info, std::uint8_t* ptr_data)
+        ring_base::span_t ring_base::push_n (ring_info& info, const std::uint8_t* ptr_data, span_t n_elems)
         {
-            bool retval = false;
-            if ( sanity_check(info) && nullptr != ptr_data)
+            span_t retval = 0u;
+
+            if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
             {
                 DISABLE_INTERRUPTS();
 
-                std::uint8_t* ptr = ptr_to_end(info, endpoint::Tail);
-                feature_t* ptr_prop = ptr_elem_feature(info, ptr);
-
-                if ( !ptr_prop->b_hidden )
+                span_t skip = 0u;
+                if (info.infinite)
                 {
-                    memcpy(ptr_data, ptr, info.elem_size);
+                    if (n_elems > info.size)
+                    {
+                        // older elements would be overwritten by the newer ones anyway
+                        skip = n_elems - info.size;
+                        ptr_data += skip * info.elem_size;
+                        n_elems = info.size;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    if (n_elems > (info.size - info.n))
+                    {
+                        // discard the oldest records, hidden or not
+                        const span_t drop = n_elems - (info.size - info.n);
+                        const std::uint32_t tail = static_cast<std::uint32_t>(info.tail) + drop;
+
+                        info.tail = static_cast<span_t>((tail < info.size) ? tail : (tail - info.size));
+                        info.n -= drop;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                const span_t m = (n_elems < (info.size - info.n)) ? n_elems : (info.size - info.n);
+
+                span_t head = info.head;
+                for (span_t i = 0u; i < m; ++i)
+                {
+                    std::uint8_t* ptr = info.ptr_buff + head * info.stride;
+                    feature_t* ptr_prop = ptr_elem_feature(info, ptr);
+
+                    std::memcpy(ptr, ptr_data, info.elem_size);
+                    ptr_data += info.elem_size;
+
+                    ptr_prop->b_visited = false;
+                    ptr_prop->b_hidden = false;
+
+                    if (++head >= info.size)
+                    {
+                        head = 0u;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+
+                info.head = head;
+                info.n += m;
+
+                ENABLE_INTERRUPTS();
+
+                retval = m + skip;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes up to n_elems oldest elements at once within a single critical section
+        *  and returns the number of removed elements. Stops at the first hidden element.
+        *  With ptr_data set to nullptr the elements are discarded.
+        *
+        */
+        ring_base::span_t ring_base::pop_n (ring_info& info, std::uint8_t* ptr_data, span_t n_elems)
+        {
+            span_t m = 0u;
+
+            if (nullptr != info.ptr_buff)
+            {
+                DISABLE_INTERRUPTS();
+
+                const span_t avail = (n_elems < info.n) ? n_elems : info.n;
+
+                span_t tail = info.tail;
+                while (m < avail)
+                {
+                    std::uint8_t* ptr = info.ptr_buff + tail * info.stride;
+                    feature_t* ptr_prop = ptr_elem_feature(info, ptr);
+
+                    if ( ptr_prop->b_hidden )
+                    {
+                        break;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    if (nullptr != ptr_data)
+                    {
+                        std::memcpy(ptr_data, ptr, info.elem_size);
+                        ptr_data += info.elem_size;
+                    }
+                    else
+                    {
+                        // just discard the record without returning its copy
+                    }
+
+                    ptr_prop->b_visited = false;
+
+                    if (++tail >= info.size)
+                    {
+                        tail = 0u;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    ++m;
+                }
+
+                info.tail = tail;
+                info.n -= m;
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return m;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the oldest element of ring buffer but does not remove it from the fifo.
+        *  Only marks the element as 'visited'.
+        *
+        */
+        bool ring_base::read_shadow (ring_info& info, std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+            if ( sanity_check(info) && nullptr != ptr_data)
+            {
+                DISABLE_INTERRUPTS();
+
+                std::uint8_t* ptr = ptr_to_end(info, endpoint::Tail);
+                feature_t* ptr_prop = ptr_elem_feature(info, ptr);
+
+                if ( !ptr_prop->b_hidden )
+                {
+                    memcpy(ptr_data, ptr, info.elem_size);
 
                     ptr_prop->b_visited = true;
 
@@ -644,6 +1167,1956 @@ namespace cel
 
             return retval;
         }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns i-th oldest element without marking it as 'visited' or nullptr if
+        *  there are not as many elements. Hidden elements are returned as well.
+        *
+        */
+        const std::uint8_t* ring_base::peek_at (const ring_info& info, span_t i)
+        {
+            const std::uint8_t* ptr_retval = nullptr;
+
+            if (nullptr != info.ptr_buff)
+            {
+                DISABLE_INTERRUPTS();
+
+                if (i < info.n)
+                {
+                    const std::uint32_t idx = static_cast<std::uint32_t>(info.tail) + i;
+                    ptr_retval = info.ptr_buff + ((idx < info.size) ? idx : (idx - info.size)) * info.stride;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return ptr_retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns number of available elements in the ring buffer. The value is exact
+        *  when called by producer or consumer and a snapshot when called by others.
+        *
+        */
+        template <bool b_cached>
+        typename basic_ring_spsc<b_cached>::span_t basic_ring_spsc<b_cached>::get_count(const ring_info& info)
+        {
+            span_t n = 0u;
+
+            if (nullptr != info.ptr_buff)
+            {
+                const span_t tail = info.tail.load(std::memory_order_acquire);
+                const span_t head = info.head.load(std::memory_order_acquire);
+                n = count(info, head, tail);
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return n;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Resets ring buffer
+        *
+        */
+        template <bool b_cached>
+        void basic_ring_spsc<b_cached>::reset(ring_info& info)
+        {
+            info.head.store(0u, std::memory_order_relaxed);
+            info.tail_cache = 0u;
+            info.head_cache = 0u;
+            info.tail.store(0u, std::memory_order_release);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Pushes a new element to the top of ring buffer. Must be called by producer only.
+        *  The element becomes visible to consumer once head is published.
+        *
+        */
+        template <bool b_cached>
+        bool basic_ring_spsc<b_cached>::push(ring_info& info, const std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+            {
+                const span_t head = info.head.load(std::memory_order_relaxed);
+
+                if (free_space(info, head, 1u) > 0u)
+                {
+                    std::memcpy(ptr_elem(info, head), ptr_data, info.elem_size);
+                    info.head.store(next(info, head), std::memory_order_release);
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes and returns the oldest element from buffer. Must be called by consumer
+        *  only. With ptr_data set to nullptr the element is discarded.
+        *
+        */
+        template <bool b_cached>
+        bool basic_ring_spsc<b_cached>::pop(ring_info& info, std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            if (nullptr != info.ptr_buff)
+            {
+                const span_t tail = info.tail.load(std::memory_order_relaxed);
+
+                if (ready_count(info, tail, 1u) > 0u)
+                {
+                    if (nullptr != ptr_data)
+                    {
+                        std::memcpy(ptr_data, ptr_elem(info, tail), info.elem_size);
+                    }
+                    else
+                    {
+                        // just discard the record without returning its copy
+                    }
+
+                    // the slot is handed back to producer only after it has been read
+                    info.tail.store(next(info, tail), std::memory_order_release);
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Pushes up to n_elems elements at once and returns the number of pushed elements.
+        *  The elements are copied with at most two memcpy calls, before and after the
+        *  wraparound. Must be called by producer only.
+        *
+        */
+        template <bool b_cached>
+        typename basic_ring_spsc<b_cached>::span_t basic_ring_spsc<b_cached>::push_n(ring_info& info, const std::uint8_t* ptr_data, span_t n_elems)
+        {
+            span_t m = 0u;
+
+            if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+            {
+                const span_t head = info.head.load(std::memory_order_relaxed);
+
+                const span_t space = free_space(info, head, n_elems);
+                m = (n_elems < space) ? n_elems : space;
+
+                if (m > 0u)
+                {
+                    const span_t slot = (head < info.size) ? head : (head - info.size);
+                    const span_t first = ((info.size - slot) < m) ? (info.size - slot) : m;
+
+                    std::memcpy(info.ptr_buff + slot * info.elem_size, ptr_data, first * info.elem_size);
+                    std::memcpy(info.ptr_buff, ptr_data + first * info.elem_size, (m - first) * info.elem_size);
+
+                    info.head.store(detail::advance(head, m, 2u * info.size), std::memory_order_release);
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return m;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes up to n_elems oldest elements at once and returns the number of removed
+        *  elements. The elements are copied with at most two memcpy calls. With ptr_data
+        *  set to nullptr the elements are discarded. Must be called by consumer only.
+        *
+        */
+        template <bool b_cached>
+        typename basic_ring_spsc<b_cached>::span_t basic_ring_spsc<b_cached>::pop_n(ring_info& info, std::uint8_t* ptr_data, span_t n_elems)
+        {
+            span_t m = 0u;
+
+            if (nullptr != info.ptr_buff)
+            {
+                const span_t tail = info.tail.load(std::memory_order_relaxed);
+
+                const span_t avail = ready_count(info, tail, n_elems);
+                m = (n_elems < avail) ? n_elems : avail;
+
+                if ((m > 0u) && (nullptr != ptr_data))
+                {
+                    const span_t slot = (tail < info.size) ? tail : (tail - info.size);
+                    const span_t first = ((info.size - slot) < m) ? (info.size - slot) : m;
+
+                    std::memcpy(ptr_data, info.ptr_buff + slot * info.elem_size, first * info.elem_size);
+                    std::memcpy(ptr_data + first * info.elem_size, info.ptr_buff, (m - first) * info.elem_size);
+                }
+                else
+                {
+                    // just discard the records without returning their copies
+                }
+
+                info.tail.store(detail::advance(tail, m, 2u * info.size), std::memory_order_release);
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return m;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the oldest element of ring buffer but does not remove it from the fifo.
+        *  Must be called by consumer only.
+        *
+        */
+        template <bool b_cached>
+        bool basic_ring_spsc<b_cached>::read_shadow(ring_info& info, std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            const std::uint8_t* ptr = read_shadow_ptr(info);
+            if ((nullptr != ptr) && (nullptr != ptr_data))
+            {
+                std::memcpy(ptr_data, ptr, info.elem_size);
+                retval = true;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns direct pointer to the oldest element of ring buffer. The pointer stays
+        *  valid till the consumer pops the element.
+        *
+        */
+        template <bool b_cached>
+        const std::uint8_t* basic_ring_spsc<b_cached>::read_shadow_ptr(ring_info& info)
+        {
+            const std::uint8_t* ptr_retval = nullptr;
+
+            if (nullptr != info.ptr_buff)
+            {
+                const span_t tail = info.tail.load(std::memory_order_relaxed);
+
+                if (ready_count(info, tail, 1u) > 0u)
+                {
+                    ptr_retval = ptr_elem(info, tail);
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return ptr_retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns i-th oldest element or nullptr if there are not as many elements.
+        *  Must be called by consumer only.
+        *
+        */
+        template <bool b_cached>
+        const std::uint8_t* basic_ring_spsc<b_cached>::peek_at(const ring_info& info, span_t i)
+        {
+            const std::uint8_t* ptr_retval = nullptr;
+
+            if (nullptr != info.ptr_buff)
+            {
+                const span_t tail = info.tail.load(std::memory_order_relaxed);
+                const span_t head = info.head.load(std::memory_order_acquire);
+
+                if (i < count(info, head, tail))
+                {
+                    ptr_retval = ptr_elem(info, detail::advance(tail, i, 2u * info.size));
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return ptr_retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns up to n_elems free slots following the head. The producer writes the
+        *  elements in place and publishes them with commit. Must be called by producer
+        *  only.
+        *
+        */
+        template <bool b_cached>
+        ring_region<std::uint8_t> basic_ring_spsc<b_cached>::reserve(ring_info& info, span_t n_elems)
+        {
+            ring_region<std::uint8_t> reg = { { nullptr, nullptr }, { 0u, 0u } };
+
+            if (nullptr != info.ptr_buff)
+            {
+                const span_t head = info.head.load(std::memory_order_relaxed);
+
+                const span_t space = free_space(info, head, n_elems);
+                reg = region(info, head, (n_elems < space) ? n_elems : space);
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return reg;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Makes n_elems reserved elements visible to the consumer and returns their
+        *  number, which is limited by the free space. Must be called by producer only.
+        *
+        */
+        template <bool b_cached>
+        typename basic_ring_spsc<b_cached>::span_t basic_ring_spsc<b_cached>::commit(ring_info& info, span_t n_elems)
+        {
+            span_t m = 0u;
+
+            if (nullptr != info.ptr_buff)
+            {
+                const span_t head = info.head.load(std::memory_order_relaxed);
+
+                const span_t space = free_space(info, head, n_elems);
+                m = (n_elems < space) ? n_elems : space;
+
+                info.head.store(detail::advance(head, m, 2u * info.size), std::memory_order_release);
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return m;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns up to n_elems oldest elements without removing them. The consumer
+        *  reads the elements in place and releases them with consume. Must be called by
+        *  consumer only.
+        *
+        */
+        template <bool b_cached>
+        ring_region<const std::uint8_t> basic_ring_spsc<b_cached>::peek(ring_info& info, span_t n_elems)
+        {
+            ring_region<std::uint8_t> reg = { { nullptr, nullptr }, { 0u, 0u } };
+
+            if (nullptr != info.ptr_buff)
+            {
+                const span_t tail = info.tail.load(std::memory_order_relaxed);
+
+                const span_t avail = ready_count(info, tail, n_elems);
+                reg = region(info, tail, (n_elems < avail) ? n_elems : avail);
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return { { reg.ptr[0], reg.ptr[1] }, { reg.count[0], reg.count[1] } };
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes n_elems oldest elements and returns their number, which is limited
+        *  by the count of elements. Must be called by consumer only.
+        *
+        */
+        template <bool b_cached>
+        typename basic_ring_spsc<b_cached>::span_t basic_ring_spsc<b_cached>::consume(ring_info& info, span_t n_elems)
+        {
+            return pop_n(info, nullptr, n_elems);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns region of n_elems slots starting at index idx
+        *
+        */
+        template <bool b_cached>
+        ring_region<std::uint8_t> basic_ring_spsc<b_cached>::region(const ring_info& info, span_t idx, span_t n_elems)
+        {
+            ring_region<std::uint8_t> reg = { { nullptr, nullptr }, { 0u, 0u } };
+
+            if (n_elems > 0u)
+            {
+                const span_t slot = (idx < info.size) ? idx : (idx - info.size);
+                const span_t first = ((info.size - slot) < n_elems) ? (info.size - slot) : n_elems;
+
+                reg.ptr[0] = info.ptr_buff + slot * info.elem_size;
+                reg.count[0] = first;
+
+                if (first < n_elems)
+                {
+                    reg.ptr[1] = info.ptr_buff;
+                    reg.count[1] = n_elems - first;
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return reg;
+        }
+
+        template class basic_ring_spsc<false>;
+        template class basic_ring_spsc<true>;
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Initializes sequence numbers of the slots. A ring of size which is not a power
+        *  of two or requested as infinite is not usable and reports no buffer.
+        *
+        */
+        ring_mpmc::ring_info::ring_info(std::uint8_t* ptr, span_t sz, span_t elem_size, bool b_infinite, span_t stride)
+                                                        : ptr_buff( ((0u != sz) && (0u == (sz & (sz - 1u))) && !b_infinite) ? ptr : nullptr ),
+                                                        size(sz),
+                                                        elem_size(elem_size),
+                                                        stride(stride),
+                                                        head(0u),
+                                                        tail(0u)
+        {
+            ring_mpmc::reset(*this);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns number of elements in the ring buffer at the moment of the call
+        *
+        */
+        ring_mpmc::span_t ring_mpmc::get_count(const ring_info& info)
+        {
+            const seq_t tail = info.tail.load(std::memory_order_acquire);
+            const seq_t head = info.head.load(std::memory_order_acquire);
+
+            // indices are read one after another, so tail may have passed head meanwhile.
+            // The signed distance stays correct when the sequences wrap
+            const std::int32_t d = static_cast<std::int32_t>(head - tail);
+
+            return (d > 0) ? static_cast<span_t>(d) : 0u;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Resets ring buffer
+        *
+        */
+        void ring_mpmc::reset(ring_info& info)
+        {
+            if (nullptr != info.ptr_buff)
+            {
+                for (span_t i = 0u; i < info.size; ++i)
+                {
+                    // every slot is first expected by the producer at its own position
+                    new (ptr_seq(info, ptr_elem(info, i))) std::atomic<seq_t>(i);
+                }
+
+                info.head.store(0u, std::memory_order_relaxed);
+                info.tail.store(0u, std::memory_order_release);
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Pushes a new element to the top of ring buffer. A producer claims the slot by
+        *  advancing head and publishes the element by advancing the sequence number.
+        *
+        */
+        bool ring_mpmc::push(ring_info& info, const std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+            {
+                seq_t pos = info.head.load(std::memory_order_relaxed);
+                std::uint8_t* ptr = nullptr;
+
+                for (;;)
+                {
+                    ptr = ptr_elem(info, pos);
+                    const seq_t seq = ptr_seq(info, ptr)->load(std::memory_order_acquire);
+                    const std::int32_t diff = static_cast<std::int32_t>(seq - pos);
+
+                    if (0 == diff)
+                    {
+                        // the slot is free at this position, try to claim it
+                        if (info.head.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed))
+                        {
+                            retval = true;
+                            break;
+                        }
+                        else
+                        {
+                            // pos is updated by the failed exchange
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        // the slot still holds an element of the previous round, ring is full
+                        break;
+                    }
+                    else
+                    {
+                        // another producer took the slot, catch up
+                        pos = info.head.load(std::memory_order_relaxed);
+                    }
+                }
+
+                if (retval)
+                {
+                    std::memcpy(ptr, ptr_data, info.elem_size);
+                    ptr_seq(info, ptr)->store(pos + 1u, std::memory_order_release);
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes and returns the oldest element from buffer. With ptr_data set to nullptr
+        *  the element is discarded. The slot is handed to the producer of the next round.
+        *
+        */
+        bool ring_mpmc::pop(ring_info& info, std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            if (nullptr != info.ptr_buff)
+            {
+                seq_t pos = info.tail.load(std::memory_order_relaxed);
+                std::uint8_t* ptr = nullptr;
+
+                for (;;)
+                {
+                    ptr = ptr_elem(info, pos);
+                    const seq_t seq = ptr_seq(info, ptr)->load(std::memory_order_acquire);
+                    const std::int32_t diff = static_cast<std::int32_t>(seq - (pos + 1u));
+
+                    if (0 == diff)
+                    {
+                        // the slot is published at this position, try to claim it
+                        if (info.tail.compare_exchange_weak(pos, pos + 1u, std::memory_order_relaxed))
+                        {
+                            retval = true;
+                            break;
+                        }
+                        else
+                        {
+                            // pos is updated by the failed exchange
+                        }
+                    }
+                    else if (diff < 0)
+                    {
+                        // nothing published yet, ring is empty
+                        break;
+                    }
+                    else
+                    {
+                        // another consumer took the slot, catch up
+                        pos = info.tail.load(std::memory_order_relaxed);
+                    }
+                }
+
+                if (retval)
+                {
+                    if (nullptr != ptr_data)
+                    {
+                        std::memcpy(ptr_data, ptr, info.elem_size);
+                    }
+                    else
+                    {
+                        // just discard the record without returning its copy
+                    }
+
+                    ptr_seq(info, ptr)->store(pos + info.size, std::memory_order_release);
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Places the bitmaps of marks right after the elements and clears them
+        *
+        */
+        ring_soa::ring_info::ring_info(std::uint8_t* ptr, span_t sz, span_t elem_size, bool infinite, span_t)
+                                                        : ptr_buff(ptr),
+                                                        ptr_visited( (nullptr != ptr) ? (ptr + sz * elem_size) : nullptr ),
+                                                        ptr_hidden( (nullptr != ptr) ? (ptr + sz * elem_size + bitmap_size(sz)) : nullptr ),
+                                                        head(0u),
+                                                        tail(0u),
+                                                        n(0u),
+                                                        size(sz),
+                                                        elem_size(elem_size),
+                                                        infinite(infinite)
+        {
+            if (nullptr != ptr)
+            {
+                std::memset(ptr_visited, 0, 2u * bitmap_size(sz));
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns number of available elements in the ring buffer
+        *
+        */
+        ring_soa::span_t ring_soa::get_count(const ring_info& info)
+        {
+            DISABLE_INTERRUPTS();
+            span_t n = info.n;
+            ENABLE_INTERRUPTS();
+
+            return n;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Resets ring buffer
+        *
+        */
+        void ring_soa::reset(ring_info& info)
+        {
+            DISABLE_INTERRUPTS();
+            info.n = 0u;
+            info.head = 0u;
+            info.tail = 0u;
+            ENABLE_INTERRUPTS();
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Pushes a new element to the top of ring buffer, optionally as hidden. In
+        *  infinite mode the oldest element is discarded if the buffer is full.
+        *
+        */
+        bool ring_soa::push(ring_info& info, const std::uint8_t* ptr_data, bool b_hidden)
+        {
+            bool retval = false;
+
+            if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+            {
+                DISABLE_INTERRUPTS();
+
+                if ((info.size == info.n) && info.infinite)
+                {
+                    // discard the oldest record even if it is hidden
+                    set_mark(info.ptr_visited, info.tail, false);
+                    set_mark(info.ptr_hidden, info.tail, false);
+                    info.tail = detail::advance(info.tail, 1u, info.size);
+                    --(info.n);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                if (info.size > info.n)
+                {
+                    std::memcpy(info.ptr_buff + info.head * info.elem_size, ptr_data, info.elem_size);
+                    set_mark(info.ptr_visited, info.head, false);
+                    set_mark(info.ptr_hidden, info.head, b_hidden);
+                    info.head = detail::advance(info.head, 1u, info.size);
+                    ++(info.n);
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes and returns the oldest element from buffer.
+        *
+        */
+        bool ring_soa::pop(ring_info& info, std::uint8_t* ptr_data)
+        {
+            return (1u == pop_n(info, ptr_data, 1u));
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Pushes up to n_elems elements at once and returns the number of pushed
+        *  elements. The elements are copied with at most two memcpy calls. In infinite
+        *  mode the oldest elements are discarded to make room and, if n_elems exceeds
+        *  the size of the buffer, only the newest elements are stored.
+        *
+        */
+        ring_soa::span_t ring_soa::push_n(ring_info& info, const std::uint8_t* ptr_data, span_t n_elems)
+        {
+            span_t retval = 0u;
+
+            if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+            {
+                DISABLE_INTERRUPTS();
+
+                span_t skip = 0u;
+                if (info.infinite)
+                {
+                    if (n_elems > info.size)
+                    {
+                        // older elements would be overwritten by the newer ones anyway
+                        skip = n_elems - info.size;
+                        ptr_data += skip * info.elem_size;
+                        n_elems = info.size;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    if (n_elems > (info.size - info.n))
+                    {
+                        // discard the oldest records, hidden or not
+                        const span_t drop = n_elems - (info.size - info.n);
+
+                        info.tail = detail::advance(info.tail, drop, info.size);
+                        info.n -= drop;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                const span_t m = (n_elems < (info.size - info.n)) ? n_elems : (info.size - info.n);
+
+                copy_in(info, ptr_data, m);
+
+                clear_marks(info, info.ptr_visited, info.head, m);
+                clear_marks(info, info.ptr_hidden, info.head, m);
+
+                info.head = detail::advance(info.head, m, info.size);
+                info.n += m;
+
+                ENABLE_INTERRUPTS();
+
+                retval = m + skip;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes up to n_elems oldest elements at once and returns the number of
+        *  removed elements. Stops at the first hidden element. The elements are copied
+        *  with at most two memcpy calls or discarded if ptr_data is nullptr.
+        *
+        */
+        ring_soa::span_t ring_soa::pop_n(ring_info& info, std::uint8_t* ptr_data, span_t n_elems)
+        {
+            span_t m = 0u;
+
+            if (nullptr != info.ptr_buff)
+            {
+                DISABLE_INTERRUPTS();
+
+                const span_t avail = (n_elems < info.n) ? n_elems : info.n;
+
+                m = count_unmarked(info, info.ptr_hidden, info.tail, avail);
+
+                if (nullptr != ptr_data)
+                {
+                    copy_out(info, ptr_data, m);
+                }
+                else
+                {
+                    // just discard the records without returning their copies
+                }
+
+                clear_marks(info, info.ptr_visited, info.tail, m);
+
+                info.tail = detail::advance(info.tail, m, info.size);
+                info.n -= m;
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return m;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the oldest element of ring buffer but does not remove it from the fifo.
+        *  Only marks the element as 'visited'.
+        *
+        */
+        bool ring_soa::read_shadow(ring_info& info, std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            if (nullptr != ptr_data)
+            {
+                DISABLE_INTERRUPTS();
+
+                const std::uint8_t* ptr = shadow(info);
+                if (nullptr != ptr)
+                {
+                    std::memcpy(ptr_data, ptr, info.elem_size);
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns direct pointer to the oldest element and marks it as 'visited'
+        *
+        */
+        const std::uint8_t* ring_soa::read_shadow_ptr(ring_info& info)
+        {
+            DISABLE_INTERRUPTS();
+            const std::uint8_t* ptr = shadow(info);
+            ENABLE_INTERRUPTS();
+
+            return ptr;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes the oldest element from the ring buffer if the former is marked as
+        *  'visited'
+        *
+        */
+        bool ring_soa::pop_if_visited(ring_info& info)
+        {
+            bool retval = false;
+
+            DISABLE_INTERRUPTS();
+
+            if ((info.n > 0u) && get_mark(info.ptr_visited, info.tail))
+            {
+                set_mark(info.ptr_visited, info.tail, false);
+                info.tail = detail::advance(info.tail, 1u, info.size);
+                --(info.n);
+
+                retval = true;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            ENABLE_INTERRUPTS();
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Checks if the oldest element in the ring buffer is marked as 'visited'
+        *
+        */
+        bool ring_soa::is_node_visited(ring_info& info)
+        {
+            DISABLE_INTERRUPTS();
+            const bool retval = (info.n > 0u) && get_mark(info.ptr_visited, info.tail);
+            ENABLE_INTERRUPTS();
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Unhides the oldest element if it is marked as 'hidden'
+        *
+        */
+        bool ring_soa::unhide_if_hidden(ring_info& info)
+        {
+            bool retval = false;
+
+            DISABLE_INTERRUPTS();
+
+            if ((info.n > 0u) && get_mark(info.ptr_hidden, info.tail))
+            {
+                set_mark(info.ptr_hidden, info.tail, false);
+                retval = true;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            ENABLE_INTERRUPTS();
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns i-th oldest element without marking it as 'visited' or nullptr if
+        *  there are not as many elements. Hidden elements are returned as well.
+        *
+        */
+        const std::uint8_t* ring_soa::peek_at(const ring_info& info, span_t i)
+        {
+            const std::uint8_t* ptr = nullptr;
+
+            DISABLE_INTERRUPTS();
+
+            if (i < info.n)
+            {
+                ptr = info.ptr_buff + detail::advance(info.tail, i, info.size) * info.elem_size;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            ENABLE_INTERRUPTS();
+
+            return ptr;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Clears marks of count elements starting at idx. Whole bytes of the bitmap
+        *  are cleared at once.
+        *
+        */
+        void ring_soa::clear_marks(const ring_info& info, std::uint8_t* bitmap, span_t idx, span_t count)
+        {
+            while (count > 0u)
+            {
+                if ((0u == (idx & 7u)) && (count >= 8u) && ((idx + 8u) <= info.size))
+                {
+                    bitmap[idx >> 3u] = 0u;
+                    idx = detail::advance(idx, 8u, info.size);
+                    count -= 8u;
+                }
+                else
+                {
+                    set_mark(bitmap, idx, false);
+                    idx = detail::advance(idx, 1u, info.size);
+                    --count;
+                }
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the number of elements without the mark among up to count elements
+        *  starting at idx. Whole bytes of the bitmap are checked at once.
+        *
+        */
+        ring_soa::span_t ring_soa::count_unmarked(const ring_info& info, const std::uint8_t* bitmap, span_t idx, span_t count)
+        {
+            span_t m = 0u;
+
+            while (m < count)
+            {
+                if ((0u == (idx & 7u)) && ((m + 8u) <= count) && ((idx + 8u) <= info.size) && (0u == bitmap[idx >> 3u]))
+                {
+                    idx = detail::advance(idx, 8u, info.size);
+                    m += 8u;
+                }
+                else if ( !get_mark(bitmap, idx) )
+                {
+                    idx = detail::advance(idx, 1u, info.size);
+                    ++m;
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            return m;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Copies count elements to the head, before and after the wraparound
+        *
+        */
+        void ring_soa::copy_in(ring_info& info, const std::uint8_t* ptr_data, span_t count)
+        {
+            const span_t first = ((info.size - info.head) < count) ? (info.size - info.head) : count;
+
+            std::memcpy(info.ptr_buff + info.head * info.elem_size, ptr_data, first * info.elem_size);
+            std::memcpy(info.ptr_buff, ptr_data + first * info.elem_size, (count - first) * info.elem_size);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Copies count elements from the tail, before and after the wraparound
+        *
+        */
+        void ring_soa::copy_out(const ring_info& info, std::uint8_t* ptr_data, span_t count)
+        {
+            const span_t first = ((info.size - info.tail) < count) ? (info.size - info.tail) : count;
+
+            std::memcpy(ptr_data, info.ptr_buff + info.tail * info.elem_size, first * info.elem_size);
+            std::memcpy(ptr_data + first * info.elem_size, info.ptr_buff, (count - first) * info.elem_size);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the oldest element marked as visited or nullptr if there is none or
+        *  it is hidden. Must be called with interrupts disabled.
+        *
+        */
+        const std::uint8_t* ring_soa::shadow(ring_info& info)
+        {
+            const std::uint8_t* ptr = nullptr;
+
+            if ((info.n > 0u) && !get_mark(info.ptr_hidden, info.tail))
+            {
+                set_mark(info.ptr_visited, info.tail, true);
+                ptr = info.ptr_buff + info.tail * info.elem_size;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return ptr;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns number of available elements in the ring buffer
+        *
+        */
+        ring_fifo::span_t ring_fifo::get_count(const ring_info& info)
+        {
+            DISABLE_INTERRUPTS();
+            span_t n = info.n;
+            ENABLE_INTERRUPTS();
+
+            return n;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Resets ring buffer
+        *
+        */
+        void ring_fifo::reset(ring_info& info)
+        {
+            DISABLE_INTERRUPTS();
+            info.n = 0u;
+            info.head = 0u;
+            info.tail = 0u;
+            ENABLE_INTERRUPTS();
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Pushes a new element to the top of ring buffer. In infinite mode the oldest
+        *  element is discarded if the buffer is full.
+        *
+        */
+        bool ring_fifo::push(ring_info& info, const std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+            {
+                DISABLE_INTERRUPTS();
+
+                if ((info.size == info.n) && info.infinite)
+                {
+                    info.tail = detail::advance(info.tail, 1u, info.size);
+                    --(info.n);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                if (info.size > info.n)
+                {
+                    std::memcpy(info.ptr_buff + info.head * info.elem_size, ptr_data, info.elem_size);
+                    info.head = detail::advance(info.head, 1u, info.size);
+                    ++(info.n);
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes and returns the oldest element from buffer.
+        *
+        */
+        bool ring_fifo::pop(ring_info& info, std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            if (nullptr != info.ptr_buff)
+            {
+                DISABLE_INTERRUPTS();
+
+                if (info.n > 0u)
+                {
+                    if (nullptr != ptr_data)
+                    {
+                        std::memcpy(ptr_data, info.ptr_buff + info.tail * info.elem_size, info.elem_size);
+                    }
+                    else
+                    {
+                        // just discard the record without returning its copy
+                    }
+
+                    info.tail = detail::advance(info.tail, 1u, info.size);
+                    --(info.n);
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Pushes up to n_elems elements at once with at most two memcpy calls and
+        *  returns the number of pushed elements. In infinite mode the oldest elements
+        *  are discarded to make room and, if n_elems exceeds the size of the buffer,
+        *  only the newest elements are stored.
+        *
+        */
+        ring_fifo::span_t ring_fifo::push_n(ring_info& info, const std::uint8_t* ptr_data, span_t n_elems)
+        {
+            span_t retval = 0u;
+
+            if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+            {
+                DISABLE_INTERRUPTS();
+
+                span_t skip = 0u;
+                if (info.infinite)
+                {
+                    if (n_elems > info.size)
+                    {
+                        // older elements would be overwritten by the newer ones anyway
+                        skip = n_elems - info.size;
+                        ptr_data += skip * info.elem_size;
+                        n_elems = info.size;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    if (n_elems > (info.size - info.n))
+                    {
+                        const span_t drop = n_elems - (info.size - info.n);
+
+                        info.tail = detail::advance(info.tail, drop, info.size);
+                        info.n -= drop;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                const span_t m = (n_elems < (info.size - info.n)) ? n_elems : (info.size - info.n);
+                const span_t first = ((info.size - info.head) < m) ? (info.size - info.head) : m;
+
+                std::memcpy(info.ptr_buff + info.head * info.elem_size, ptr_data, first * info.elem_size);
+                std::memcpy(info.ptr_buff, ptr_data + first * info.elem_size, (m - first) * info.elem_size);
+
+                info.head = detail::advance(info.head, m, info.size);
+                info.n += m;
+
+                ENABLE_INTERRUPTS();
+
+                retval = m + skip;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes up to n_elems oldest elements at once with at most two memcpy calls
+        *  and returns the number of removed elements. With ptr_data set to nullptr the
+        *  elements are discarded.
+        *
+        */
+        ring_fifo::span_t ring_fifo::pop_n(ring_info& info, std::uint8_t* ptr_data, span_t n_elems)
+        {
+            span_t m = 0u;
+
+            if (nullptr != info.ptr_buff)
+            {
+                DISABLE_INTERRUPTS();
+
+                m = (n_elems < info.n) ? n_elems : info.n;
+
+                if (nullptr != ptr_data)
+                {
+                    const span_t first = ((info.size - info.tail) < m) ? (info.size - info.tail) : m;
+
+                    std::memcpy(ptr_data, info.ptr_buff + info.tail * info.elem_size, first * info.elem_size);
+                    std::memcpy(ptr_data + first * info.elem_size, info.ptr_buff, (m - first) * info.elem_size);
+                }
+                else
+                {
+                    // just discard the records without returning their copies
+                }
+
+                info.tail = detail::advance(info.tail, m, info.size);
+                info.n -= m;
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return m;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the oldest element of ring buffer but does not remove it from the fifo
+        *
+        */
+        bool ring_fifo::read_shadow(ring_info& info, std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            if (nullptr != ptr_data)
+            {
+                DISABLE_INTERRUPTS();
+
+                if (info.n > 0u)
+                {
+                    std::memcpy(ptr_data, info.ptr_buff + info.tail * info.elem_size, info.elem_size);
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns direct pointer to the oldest element or nullptr if the buffer is empty
+        *
+        */
+        const std::uint8_t* ring_fifo::read_shadow_ptr(ring_info& info)
+        {
+            const std::uint8_t* ptr = nullptr;
+
+            DISABLE_INTERRUPTS();
+
+            if (info.n > 0u)
+            {
+                ptr = info.ptr_buff + info.tail * info.elem_size;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            ENABLE_INTERRUPTS();
+
+            return ptr;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns i-th oldest element or nullptr if there are not as many elements
+        *
+        */
+        const std::uint8_t* ring_fifo::peek_at(const ring_info& info, span_t i)
+        {
+            const std::uint8_t* ptr = nullptr;
+
+            DISABLE_INTERRUPTS();
+
+            if (i < info.n)
+            {
+                ptr = info.ptr_buff + detail::advance(info.tail, i, info.size) * info.elem_size;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            ENABLE_INTERRUPTS();
+
+            return ptr;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Allocates the buffer from static heap
+        *
+        */
+        record_ring::record_ring(span_t size) : ptr_buff_(manual_heap::alloc<std::uint8_t>(size)),
+                                                size_(size),
+                                                head_(0u),
+                                                tail_(0u),
+                                                n_(0u)
+        {
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Releases the buffer
+        *
+        */
+        record_ring::~record_ring()
+        {
+            manual_heap::free(ptr_buff_, size_);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns number of records in the ring buffer
+        *
+        */
+        record_ring::span_t record_ring::get_count() const
+        {
+            DISABLE_INTERRUPTS();
+            span_t n = n_;
+            ENABLE_INTERRUPTS();
+
+            return n;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Resets ring buffer
+        *
+        */
+        void record_ring::reset()
+        {
+            DISABLE_INTERRUPTS();
+            head_ = 0u;
+            tail_ = 0u;
+            n_ = 0u;
+            ENABLE_INTERRUPTS();
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Appends a record of len bytes. If the record does not fit the end of the
+        *  buffer, the end is marked as unused and the record is placed at the start.
+        *  Returns false if there is not enough contiguous space.
+        *
+        */
+        bool record_ring::push(const void* ptr, span_t len)
+        {
+            bool retval = false;
+
+            const std::uint32_t need = static_cast<std::uint32_t>(len) + len_size_;
+
+            if ((nullptr != ptr_buff_) && (nullptr != ptr) && (len != wrap_marker_))
+            {
+                DISABLE_INTERRUPTS();
+
+                if (0u == n_)
+                {
+                    // start over to have the whole buffer contiguous
+                    head_ = 0u;
+                    tail_ = 0u;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                span_t pos = head_;
+                bool b_fits = false;
+
+                if ((0u == n_) || (head_ > tail_))
+                {
+                    // free space is at the end and before the tail
+                    if ((static_cast<std::uint32_t>(size_) - head_) >= need)
+                    {
+                        b_fits = true;
+                    }
+                    else if (tail_ >= need)
+                    {
+                        if ((size_ - head_) >= len_size_)
+                        {
+                            std::memcpy(ptr_buff_ + head_, &wrap_marker_, len_size_);
+                        }
+                        else
+                        {
+                            // too short for the marker, the reader skips it anyway
+                        }
+
+                        pos = 0u;
+                        b_fits = true;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    // free space is between the head and the tail
+                    b_fits = ((static_cast<std::uint32_t>(tail_) - head_) >= need);
+                }
+
+                if (b_fits)
+                {
+                    std::memcpy(ptr_buff_ + pos, &len, len_size_);
+                    std::memcpy(ptr_buff_ + pos + len_size_, ptr, len);
+
+                    pos += static_cast<span_t>(need);
+                    head_ = (pos < size_) ? pos : 0u;
+                    ++n_;
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                ENABLE_INTERRUPTS();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the oldest record without removing it
+        *
+        */
+        record_ring::record_t record_ring::peek()
+        {
+            record_t rec = { nullptr, 0u };
+
+            DISABLE_INTERRUPTS();
+
+            if (n_ > 0u)
+            {
+                skip_wrap();
+
+                std::memcpy(&rec.len, ptr_buff_ + tail_, len_size_);
+                rec.ptr = ptr_buff_ + tail_ + len_size_;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            ENABLE_INTERRUPTS();
+
+            return rec;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes the oldest record
+        *
+        */
+        bool record_ring::pop()
+        {
+            bool retval = false;
+
+            DISABLE_INTERRUPTS();
+
+            if (n_ > 0u)
+            {
+                skip_wrap();
+
+                len_t len;
+                std::memcpy(&len, ptr_buff_ + tail_, len_size_);
+
+                const std::uint32_t pos = static_cast<std::uint32_t>(tail_) + len_size_ + len;
+                tail_ = (pos < size_) ? static_cast<span_t>(pos) : 0u;
+                --n_;
+
+                retval = true;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            ENABLE_INTERRUPTS();
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Moves the tail to the start of the buffer if the rest of the buffer is
+        *  marked as unused or too short for a record
+        *
+        */
+        void record_ring::skip_wrap()
+        {
+            len_t len = wrap_marker_;
+
+            if ((size_ - tail_) >= len_size_)
+            {
+                std::memcpy(&len, ptr_buff_ + tail_, len_size_);
+            }
+            else
+            {
+                // do nothing
+            }
+
+            if (wrap_marker_ == len)
+            {
+                tail_ = 0u;
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Claims a free cursor and announces it to the producer, which places it at
+        *  the head before its next push
+        *
+        */
+        ring_multicast::consumer_t ring_multicast::attach(ring_info& info)
+        {
+            consumer_t id = no_consumer;
+
+            for (consumer_t i = 0u; (i < CEL_MULTICAST_CONSUMERS) && (no_consumer == id); ++i)
+            {
+                std::uint8_t state = cursor_free;
+
+                if (info.cursors[i].state.compare_exchange_strong(state, cursor_joining, std::memory_order_relaxed))
+                {
+                    info.joining.fetch_or(1u << i, std::memory_order_release);
+                    id = i;
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+
+            return id;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Releases the cursor, its elements are released to the producer once the
+        *  producer reads the cursors again
+        *
+        */
+        void ring_multicast::detach(ring_info& info, consumer_t id)
+        {
+            if (id < CEL_MULTICAST_CONSUMERS)
+            {
+                info.cursors[id].state.store(cursor_free, std::memory_order_release);
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Empties the ring for all consumers
+        *
+        */
+        void ring_multicast::reset(ring_info& info)
+        {
+            info.head.store(0u, std::memory_order_relaxed);
+            info.tail_cache = 0u;
+
+            for (ring_info::cursor_t& c : info.cursors)
+            {
+                c.pos.store(0u, std::memory_order_release);
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Places the cursors of joining consumers at the head. A cursor detached in
+        *  the meantime stays free, and one claimed again is placed as well.
+        *
+        */
+        void ring_multicast::join(ring_info& info, span_t head)
+        {
+            const std::uint32_t mask = info.joining.exchange(0u, std::memory_order_acquire);
+
+            for (consumer_t i = 0u; i < CEL_MULTICAST_CONSUMERS; ++i)
+            {
+                std::uint8_t state = cursor_joining;
+
+                if ((0u != (mask & (1u << i))) && (cursor_joining == info.cursors[i].state.load(std::memory_order_relaxed)))
+                {
+                    // only producer activates a cursor, so it is still joining or has been freed
+                    info.cursors[i].pos.store(head, std::memory_order_relaxed);
+                    (void)info.cursors[i].state.compare_exchange_strong(state, cursor_active, std::memory_order_release, std::memory_order_relaxed);
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the cursor of the consumer which is the farthest behind the head,
+        *  or the head itself if no consumer is attached
+        *
+        */
+        ring_multicast::span_t ring_multicast::slowest(const ring_info& info, span_t head)
+        {
+            span_t tail = head;
+            span_t lag = 0u;
+
+            for (const ring_info::cursor_t& c : info.cursors)
+            {
+                if (cursor_active == c.state.load(std::memory_order_acquire))
+                {
+                    const span_t pos = c.pos.load(std::memory_order_acquire);
+                    if (count(info, head, pos) > lag)
+                    {
+                        lag = count(info, head, pos);
+                        tail = pos;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+
+            return tail;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Pushes a new element. The cursors are read only when the last seen slowest
+        *  cursor shows the ring full. A consumer placed at the head cannot be slower
+        *  than that cursor, so joining consumers do not make the producer read them.
+        *
+        */
+        bool ring_multicast::push(ring_info& info, const std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+
+            if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+            {
+                const span_t head = info.head.load(std::memory_order_relaxed);
+
+                if (0u != info.joining.load(std::memory_order_relaxed))
+                {
+                    join(info, head);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                if (count(info, head, info.tail_cache) >= info.size)
+                {
+                    info.tail_cache = slowest(info, head);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                if (count(info, head, info.tail_cache) < info.size)
+                {
+                    std::memcpy(ptr_elem(info, head), ptr_data, info.elem_size);
+                    info.head.store(next(info, head), std::memory_order_release);
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes and returns the oldest element of consumer id. The slot is handed
+        *  back to the producer once all consumers have popped it.
+        *
+        */
+        bool ring_multicast::pop(ring_info& info, consumer_t id, std::uint8_t* ptr_data)
+        {
+            bool retval = false;
+            span_t tail = 0u;
+
+            if (cursor(info, id, tail))
+            {
+                const span_t head = info.head.load(std::memory_order_acquire);
+
+                if (head != tail)
+                {
+                    if (nullptr != ptr_data)
+                    {
+                        std::memcpy(ptr_data, ptr_elem(info, tail), info.elem_size);
+                    }
+                    else
+                    {
+                        // just discard the element without returning its copy
+                    }
+
+                    info.cursors[id].pos.store(next(info, tail), std::memory_order_release);
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns direct pointer to the oldest element of consumer id
+        *
+        */
+        const std::uint8_t* ring_multicast::peek(const ring_info& info, consumer_t id)
+        {
+            const std::uint8_t* ptr_retval = nullptr;
+            span_t tail = 0u;
+
+            if (cursor(info, id, tail))
+            {
+                const span_t head = info.head.load(std::memory_order_acquire);
+
+                if (head != tail)
+                {
+                    ptr_retval = ptr_elem(info, tail);
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return ptr_retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns number of elements not yet popped by consumer id
+        *
+        */
+        ring_multicast::span_t ring_multicast::get_count(const ring_info& info, consumer_t id)
+        {
+            span_t n = 0u;
+            span_t tail = 0u;
+
+            if (cursor(info, id, tail))
+            {
+                n = count(info, info.head.load(std::memory_order_acquire), tail);
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return n;
+        }
     }
 
 }
\ No newline at end of file
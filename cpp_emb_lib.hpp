@@ -24,15 +24,194 @@
 #include <cstdlib>
 #include <type_traits>
 #include <tuple>
+#include <iterator>
+#include <new>
+#include <atomic>
 
 // ===================================================================
 // Defines
 // ===================================================================
+#ifndef CEL_STATIC_HEAP_SIZE
 #define CEL_STATIC_HEAP_SIZE    (4096u)
+#endif
+
+// Alignment of buffers allocated on static heap. Must be a power of two
+#ifndef CEL_STATIC_HEAP_ALIGN
+#define CEL_STATIC_HEAP_ALIGN   (4u)
+#endif
+
+// Size of CPU cache line. Ring indices written by different threads are
+// kept in separate lines. Can be reduced on MCUs without data cache
+#ifndef CEL_CACHE_LINE_SIZE
+#define CEL_CACHE_LINE_SIZE     (64u)
+#endif
+
+// Number of bins of queueing latency histogram of monitored_ring
+#ifndef CEL_RING_LATENCY_BINS
+#define CEL_RING_LATENCY_BINS   (16u)
+#endif
+
+// Maximum number of consumers of multicast_ring
+#ifndef CEL_MULTICAST_CONSUMERS
+#define CEL_MULTICAST_CONSUMERS (4u)
+#endif
+
+// Maximum number of reclaim handlers of static heap
+#ifndef CEL_RECLAIM_HANDLERS
+#define CEL_RECLAIM_HANDLERS    (4u)
+#endif
 
 
 namespace cel
 {
+    // ===================================================================
+    // Helpers of the library which are not part of its interface
+    // ===================================================================
+    namespace detail
+    {
+        // Masking of interrupts by the critical sections implemented in this
+        // header. Sections must not nest, as enabling is unconditional.
+        // Define ARM_CROSS_COMPILER for Cortex-M or add your platform here
+        inline void disable_interrupts()
+        {
+#if defined( ARM_CROSS_COMPILER )
+#if defined (__GNUC__)
+            __asm volatile ("cpsid i" : : : "memory");
+#else
+            __asm("cpsid i");
+#endif
+#endif // ARM_CROSS_COMPILER
+        }
+
+        inline void enable_interrupts()
+        {
+#if defined( ARM_CROSS_COMPILER )
+#if defined (__GNUC__)
+            __asm volatile ("cpsie i" : : : "memory");
+#else
+            __asm("cpsie i");
+#endif
+#endif // ARM_CROSS_COMPILER
+        }
+
+        // Masking of interrupts for critical sections which may nest, e.g.
+        // when a callback made inside the section enters it again. Returns
+        // the previous PRIMASK to be passed to restore_interrupts
+        inline std::uint32_t save_and_disable_interrupts()
+        {
+            std::uint32_t primask = 0u;
+#if defined( ARM_CROSS_COMPILER )
+#if defined (__GNUC__)
+            __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) : : "memory");
+#else
+            register std::uint32_t reg_primask __asm("primask");
+            primask = reg_primask;
+            __asm("cpsid i");
+#endif
+#endif // ARM_CROSS_COMPILER
+            return primask;
+        }
+
+        inline void restore_interrupts(std::uint32_t primask)
+        {
+#if defined( ARM_CROSS_COMPILER )
+#if defined (__GNUC__)
+            __asm volatile ("msr primask, %0" : : "r" (primask) : "memory");
+#else
+            register std::uint32_t reg_primask __asm("primask");
+            reg_primask = primask;
+#endif
+#else
+            (void)primask;
+#endif // ARM_CROSS_COMPILER
+        }
+
+        // Largest number of elements supported by a ring engine, engines with
+        // a narrower index range than span_t declare max_size
+        template <typename engine, typename = void>
+        struct max_ring_size : std::integral_constant<std::uint16_t, static_cast<std::uint16_t>(~0u)>
+        {};
+
+        template <typename engine>
+        struct max_ring_size<engine, std::void_t<decltype(engine::max_size)>> : std::integral_constant<std::uint16_t, engine::max_size>
+        {};
+
+        // Index of the element count elements after idx, where indices run
+        // over [0, range)
+        inline std::uint16_t advance(std::uint16_t idx, std::uint16_t count, std::uint32_t range)
+        {
+            const std::uint32_t pos = static_cast<std::uint32_t>(idx) + count;
+            return static_cast<std::uint16_t>((pos < range) ? pos : (pos - range));
+        }
+
+        template <typename engine, typename T, typename = void>
+        struct has_storage_size : std::false_type
+        {};
+
+        template <typename engine, typename T>
+        struct has_storage_size<engine, T, std::void_t<decltype(engine::template storage_size<T>(0u))>> : std::true_type
+        {};
+
+        // Number of bytes of storage for sz elements of type T. Engines which
+        // keep more than the slots, e.g. bitmaps of marks, declare storage_size
+        template <typename engine, typename T>
+        constexpr std::size_t storage_size(std::uint16_t sz)
+        {
+            std::size_t size = 0u;
+
+            if constexpr (has_storage_size<engine, T>::value)
+            {
+                size = engine::template storage_size<T>(sz);
+            }
+            else
+            {
+                size = sz * sizeof(typename engine::template slot_t<T>);
+            }
+
+            return size;
+        }
+
+        // Allocators whose storage is followed by its mirror declare mirrored
+        // as true, the others need not declare it
+        template <typename allocator, typename = void>
+        struct is_mirrored : std::false_type
+        {};
+
+        template <typename allocator>
+        struct is_mirrored<allocator, std::void_t<decltype(allocator::mirrored)>> : std::integral_constant<bool, allocator::mirrored>
+        {};
+
+        // Engines of compile time capacity declare it, so that allocators
+        // take the size from the engine instead of the constructor
+        template <typename engine, typename = void>
+        struct has_capacity : std::false_type
+        {};
+
+        template <typename engine>
+        struct has_capacity<engine, std::void_t<decltype(engine::capacity)>> : std::true_type
+        {};
+
+        // Engines which do not mask interrupts declare lock_free as true,
+        // their producer cannot remove elements nor their consumer add them
+        template <typename engine, typename = void>
+        struct is_lock_free : std::false_type
+        {};
+
+        template <typename engine>
+        struct is_lock_free<engine, std::void_t<decltype(engine::lock_free)>> : std::integral_constant<bool, engine::lock_free>
+        {};
+
+        // Engines giving access to their storage in place provide reserve,
+        // commit, peek and consume
+        template <typename engine, typename = void>
+        struct has_in_place : std::false_type
+        {};
+
+        template <typename engine>
+        struct has_in_place<engine, std::void_t<decltype(engine::reserve(std::declval<typename engine::ring_info&>(), 0u))>> : std::true_type
+        {};
+    }
+
     namespace buffer
     {
         // ===================================================================
@@ -56,14 +235,38 @@ namespace cel
 
             static void* alloc(heap_sz_t size);
             static void free(void *p);
+            static void free(void *p, heap_sz_t size);
+
+            // Size of the page of a buffer returned by alloc, which the sized free
+            // accepts. Read from the service bytes without checking the buffer, so
+            // the caller must vouch for it, or 0 if p is not on the heap
+            static heap_sz_t block_size(void *p)
+            {
+                const page_t *page = page_of(p);
+                return (nullptr != page) ? page->size : 0u;
+            }
 
             static std::uint32_t free_size()
             {
                 return free_size_;
             }
 
+            static std::uint32_t reserved_size()
+            {
+                return reserved_;
+            }
+
+            // Handler is called when allocation fails and returns true
+            // if it released some memory so that allocation is worth retrying
+            using reclaim_handler_t = bool (*)(heap_sz_t size);
+
+            static bool add_reclaim_handler(reclaim_handler_t handler, std::uint8_t priority = 0u);
+            static void remove_reclaim_handler(reclaim_handler_t handler);
+
         protected:
 
+            friend class heap_budget;
+
             static_heap()
             {}
 
@@ -71,25 +274,145 @@ namespace cel
             {
                 heap_sz_t size;
                 bool free;
+                std::uint8_t owner;     // id of the heap budget or 0, takes a padding byte
                 page_t *prev;
             };
 
         private:
 
+            struct reclaim_t
+            {
+                reclaim_handler_t handler;
+                std::uint8_t priority;
+            };
+
             static void reset();
+            static void* alloc_page(heap_sz_t size);
             static void defragment(page_t * const pg);
+            static void coalesce(page_t * const pg);
 
-            static constexpr std::uint32_t heap_size_ = CEL_STATIC_HEAP_SIZE;
-            static constexpr std::uint8_t  page_size_ = sizeof(page_t);
+            static constexpr heap_sz_t align_size(heap_sz_t size)
+            {
+                // to be on a safe side lets align to 4-byte boundary (by default)
+                // instead of just making size even
+                return static_cast<heap_sz_t>((size + (heap_align_ - 1u)) & ~(heap_align_ - 1u));
+            }
+
+            static page_t* page_of(void *p)
+            {
+                std::uint8_t *ptr = static_cast<std::uint8_t*>(p);
+                return ((ptr >= (heap_start_ + page_size_)) && (ptr < heap_end_)) ? reinterpret_cast<page_t*>(ptr - page_size_) : nullptr;
+            }
+
+            static page_t* next_page(page_t * const pg)
+            {
+                std::uint8_t *p = reinterpret_cast<std::uint8_t*>(pg) + pg->size + page_size_;
+                return (p < heap_end_) ? reinterpret_cast<page_t*>(p) : nullptr;
+            }
+
+            static constexpr std::uint32_t heap_size_  = CEL_STATIC_HEAP_SIZE;
+            static constexpr std::uint32_t heap_align_ = CEL_STATIC_HEAP_ALIGN;
+
+            // service bytes are padded so that every buffer starts aligned
+            static constexpr std::uint8_t  page_size_ = (sizeof(page_t) + (heap_align_ - 1u)) & ~(heap_align_ - 1u);
+
+            static_assert(0u == (heap_align_ & (heap_align_ - 1u)), "CEL_STATIC_HEAP_ALIGN must be a power of two");
+            static_assert((heap_size_ - page_size_) <= static_cast<heap_sz_t>(~0u), "CEL_STATIC_HEAP_SIZE does not fit heap_sz_t");
 
             static inline    std::uint32_t free_size_ = heap_size_ - page_size_;
 
-            alignas(4) static inline std::uint8_t heap_[heap_size_];
+            // free bytes kept for reservations of heap budgets
+            static inline    std::uint32_t reserved_ = 0u;
+
+            // reclaim handlers sorted by priority
+            static inline    reclaim_t     reclaim_[CEL_RECLAIM_HANDLERS] = {};
+            static inline    std::uint8_t  reclaim_count_ = 0u;
+            static inline    bool          b_reclaiming_ = false;
+
+            alignas(heap_align_) static inline std::uint8_t heap_[heap_size_];
             static constexpr std::uint8_t* const heap_start_ = &heap_[0];
 
             static constexpr std::uint8_t* const heap_end_ = heap_start_ + heap_size_;
         };
 
+        // ===================================================================
+        // Class for limiting heap usage of a subsystem. The budget reserves
+        // part of the heap which is available to it only and caps its total
+        // usage by the ceiling. Both include service bytes of the heap.
+        // The reservation is a number of bytes, not a region, so the
+        // guarantee holds only while the free space is not fragmented
+        // ===================================================================
+        class heap_budget
+        {
+        public:
+
+            heap_budget(const heap_budget&)              = delete;
+            heap_budget(heap_budget&&)                   = delete;
+
+            heap_budget& operator = (const heap_budget&) = delete;
+            heap_budget& operator = (heap_budget&&)      = delete;
+
+            heap_budget(const char* name, std::uint32_t reservation, std::uint32_t ceiling);
+
+            ~heap_budget();
+
+            void* alloc(heap_sz_t size);
+            void free(void *p);
+            void free(void *p, heap_sz_t size);
+
+            bool is_good() const
+            {
+                return b_good_;
+            }
+
+            const char* name() const
+            {
+                return name_;
+            }
+
+            std::uint32_t used() const
+            {
+                return used_;
+            }
+
+            std::uint32_t peak() const
+            {
+                return peak_;
+            }
+
+            std::uint32_t failures() const
+            {
+                return failures_;
+            }
+
+        private:
+
+            // part of the reservation not used yet
+            std::uint32_t held() const
+            {
+                return (used_ < reservation_) ? (reservation_ - used_) : 0u;
+            }
+
+            void release(void *p, heap_sz_t size, bool b_sized);
+
+            static std::uint8_t take_id();
+            static void put_id(std::uint8_t id);
+
+            // budget ids are tagged on the pages, 0 stands for no budget,
+            // a set bit marks an id of a living budget
+            static inline std::uint32_t ids_used_[256u / 32u] = { 1u };
+
+            const char* const name_;
+            const std::uint8_t id_;
+            std::uint32_t reservation_;
+            const std::uint32_t ceiling_;
+            std::uint32_t used_;
+            std::uint32_t peak_;
+            std::uint32_t failures_;
+            bool b_good_;
+            bool b_alloc_;
+        };
+
         // ===================================================================
         // Helper class for heap allocation of given type
         // ===================================================================
@@ -101,6 +424,16 @@ namespace cel
             {
                 return static_cast<T*>(static_heap::alloc( sizeof(T) * size ));
             }
+
+            using static_heap::free;
+
+            // Sized release of size elements of type T, named apart from the
+            // sized free of static_heap which takes the size in bytes
+            template <typename T>
+            static void free_n(T* p, heap_sz_t size)
+            {
+                static_heap::free(p, sizeof(T) * size);
+            }
         
         private:
             
@@ -123,13 +456,14 @@ namespace cel
             auto_heap& operator = (auto_heap&&)      = delete;
 
             explicit auto_heap(heap_sz_t n = 1u)
-            : ptr_ ( static_cast<T*>(static_heap::alloc( (n * sizeof(T)) )) )
+            : ptr_ ( static_cast<T*>(static_heap::alloc( (n * sizeof(T)) )) ),
+              size_ ( n * sizeof(T) )
             {
             }
 
             ~auto_heap()
             {
-                static_heap::free(ptr_);
+                static_heap::free(ptr_, size_);
             }
 
             T* operator &() const
@@ -154,203 +488,2658 @@ namespace cel
 
         private:
             T* const ptr_;
+            const heap_sz_t size_;
         };
 
         // ===================================================================
-        // Ring buffer base class
+        // Owning pointer to an object constructed in static heap. The object
+        // is destroyed and its buffer released when the owner goes away.
+        // Ownership is transferred by moving the pointer only
         // ===================================================================
-        class ring_base
+        template <typename T>
+        class heap_ptr : private static_heap
         {
         public:
-            using span_t = std::uint16_t;
+            heap_ptr(const heap_ptr&)              = delete;
+            heap_ptr& operator = (const heap_ptr&) = delete;
 
-            struct ring_info
+            heap_ptr() : ptr_(nullptr)
             {
-                ring_info(std::uint8_t* ptr, span_t sz, span_t elem_size, bool infinite = false)
-                                                        : ptr_buff(ptr),
-                                                        size(sz),
-                                                        elem_size(elem_size),
-                                                        infinite(infinite)
-                {
-                    head = 0u;
-                    tail = 0u;
-                    n = 0u;
-                }
-
-                std::uint8_t * const ptr_buff;
-                span_t head;
-                span_t tail;
-                span_t n;
-                const span_t size;
-                const span_t elem_size;
-                const bool infinite;
-            };
+            }
 
-            struct feature_t
+            // Takes ownership of an object constructed in static heap
+            explicit heap_ptr(T* ptr) : ptr_(ptr)
             {
-                bool b_visited;
-                bool b_hidden;
-            };
-
-            ring_base(const ring_base&)              = delete;
-            ring_base(ring_base&&)                   = delete;
-
-            ring_base& operator = (const ring_base&) = delete;
-            ring_base& operator = (ring_base&&)      = delete;
-
-            static span_t    			get_count        (const ring_info& info);
-
-            static void      			reset            (ring_info& info);
-
-            static bool      			push             (ring_info& info, const std::uint8_t* ptr_data, bool b_hidden = false);
-
-            static bool      			pop              (ring_info& info, std::uint8_t* ptr_data);
-
-            static bool      			read_shadow      (ring_info& info, std::uint8_t* ptr_data);
-
-            static const std::uint8_t*  read_shadow_ptr  (ring_info& info);
-
-            static bool      			pop_if_visited   (ring_info& info);
+            }
 
-            static bool      			is_node_visited  (ring_info& info);
+            heap_ptr(heap_ptr&& other) noexcept : ptr_(other.release())
+            {
+            }
 
-            static bool      			unhide_if_hidden (ring_info& info);
+            heap_ptr& operator = (heap_ptr&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    ptr_ = other.release();
+                }
+                else
+                {
+                    // do nothing
+                }
 
-        protected:
+                return *this;
+            }
 
-            explicit ring_base()
+            ~heap_ptr()
             {
+                reset();
             }
 
-        private:
+            T* get() const
+            {
+                return ptr_;
+            }
 
-            enum class endpoint : std::uint8_t {Head, Tail};
+            T* operator ->() const
+            {
+                return ptr_;
+            }
 
-            static constexpr std::uint8_t feature_size_ = sizeof(feature_t);
+            T& operator *() const
+            {
+                return *ptr_;
+            }
 
-            static bool sanity_check(ring_info& info, bool b_read = true);
+            explicit operator bool() const
+            {
+                return (nullptr != ptr_);
+            }
 
-            static std::uint8_t* ptr_to_end(const ring_info& info, endpoint pnt);
+            // Gives up ownership without destroying the object
+            T* release() noexcept
+            {
+                T* ptr = ptr_;
+                ptr_ = nullptr;
+                return ptr;
+            }
 
-            static feature_t* ptr_elem_feature(const ring_info& info, std::uint8_t* ptr_elem)
+            void reset() noexcept
             {
-                return reinterpret_cast<feature_t*>(ptr_elem + info.elem_size);
+                if (nullptr != ptr_)
+                {
+                    ptr_->~T();
+                    static_heap::free(ptr_, sizeof(T));
+                    ptr_ = nullptr;
+                }
+                else
+                {
+                    // do nothing
+                }
             }
 
+        private:
+            T* ptr_;
         };
 
         // ===================================================================
-        // Ring buffer allocator class. By default uses manual_heap class to 
-        // allocate buffer from static heap organized by class static_heap
+        // Owning pointer to an array of objects constructed in static heap
         // ===================================================================
         template <typename T>
-        class ring_heap_allocator
+        class heap_ptr<T[]> : private static_heap
         {
         public:
-            ring_heap_allocator(const ring_heap_allocator&)              = delete;
-            ring_heap_allocator(ring_heap_allocator&&)                   = delete;
-
-            ring_heap_allocator& operator = (const ring_heap_allocator&) = delete;
-            ring_heap_allocator& operator = (ring_heap_allocator&&)      = delete;
+            heap_ptr(const heap_ptr&)              = delete;
+            heap_ptr& operator = (const heap_ptr&) = delete;
 
-            ring_heap_allocator(ring_base::span_t sz, bool infinite = false) :
-                                        ring_buff_ ( manual_heap::alloc<T_featured>(sz) ),
-                                        info_(reinterpret_cast<std::uint8_t*>(ring_buff_), sz, sizeof(T), infinite)
+            heap_ptr() : ptr_(nullptr), count_(0u)
             {
             }
 
-            ~ring_heap_allocator()
+            // Takes ownership of n objects constructed in static heap
+            heap_ptr(T* ptr, heap_sz_t n) : ptr_(ptr), count_(nullptr != ptr ? n : 0u)
             {
-                manual_heap::free(ring_buff_);
             }
 
-        private:
-
-            struct T_featured
+            heap_ptr(heap_ptr&& other) noexcept : ptr_(other.ptr_), count_(other.count_)
             {
-                T obj;
-                ring_base::feature_t feature;
-            };
-
-            T_featured * const ring_buff_;
-
-        protected:
-
-            ring_base::ring_info info_;
-        };
+                (void)other.release();
+            }
 
-        // ===================================================================
-        // Ring buffer maker class
-        // ===================================================================
-        template <typename T, typename allocator = ring_heap_allocator<T>>
-        class ring_maker :  private allocator
-        {
-        public:
-            ring_maker(const ring_maker&)              = delete;
-            ring_maker(ring_maker&&)                   = delete;
+            heap_ptr& operator = (heap_ptr&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    reset();
+                    count_ = other.count_;
+                    ptr_ = other.release();
+                }
+                else
+                {
+                    // do nothing
+                }
 
-            ring_maker& operator = (const ring_maker&) = delete;
-            ring_maker& operator = (ring_maker&&)      = delete;
+                return *this;
+            }
 
-            explicit ring_maker(ring_base::span_t sz, bool infinite = false) : allocator(sz, infinite)
+            ~heap_ptr()
             {
+                reset();
             }
 
-            bool is_good() const
+            T* get() const
             {
-                return (nullptr != this->info_.ptr_buff ? true : false);
+                return ptr_;
             }
 
-            ring_base::span_t get_count() const
+            heap_sz_t size() const
             {
-                return ring_base::get_count(this->info_);
+                return count_;
             }
 
-            void reset ()
+            T& operator [](heap_sz_t i) const
             {
-                ring_base::reset(this->info_);
+                return *(ptr_ + i);
             }
 
-            bool push(const T& t, bool b_hidden = false)
+            explicit operator bool() const
             {
-                return ring_base::push(this->info_, reinterpret_cast<const std::uint8_t*>(&t), b_hidden);
+                return (nullptr != ptr_);
             }
 
-            bool pop()
+            T* release() noexcept
             {
-                return ring_base::pop(this->info_, nullptr);
+                T* ptr = ptr_;
+                ptr_ = nullptr;
+                count_ = 0u;
+                return ptr;
             }
 
-            bool pop(T& t)
+            void reset() noexcept
             {
-                return ring_base::pop(this->info_, reinterpret_cast<std::uint8_t*>(&t));
+                if (nullptr != ptr_)
+                {
+                    // destroy in reverse order of construction
+                    for (heap_sz_t i = count_; i > 0u; --i)
+                    {
+                        ptr_[i - 1u].~T();
+                    }
+
+                    static_heap::free(ptr_, count_ * sizeof(T));
+                    ptr_ = nullptr;
+                    count_ = 0u;
+                }
+                else
+                {
+                    // do nothing
+                }
             }
 
-            bool read_shadow(T& t)
+        private:
+            T* ptr_;
+            heap_sz_t count_;
+        };
+
+        // ===================================================================
+        // Helper class of make_heap which owns the buffer while objects are
+        // being constructed in it. If a constructor throws, the objects built
+        // so far are destroyed and the buffer is released
+        // ===================================================================
+        template <typename T>
+        class heap_build_guard : private static_heap
+        {
+        public:
+            heap_build_guard(const heap_build_guard&)              = delete;
+            heap_build_guard(heap_build_guard&&)                   = delete;
+
+            heap_build_guard& operator = (const heap_build_guard&) = delete;
+            heap_build_guard& operator = (heap_build_guard&&)      = delete;
+
+            heap_build_guard(void *p, heap_sz_t n) : ptr_(static_cast<T*>(p)), count_(n), built_(0u)
             {
-                return ring_base::read_shadow(this->info_, reinterpret_cast<std::uint8_t*>(&t));
             }
 
-            const T* read_shadow_ptr()
+            ~heap_build_guard()
             {
-                return reinterpret_cast<const T*>( ring_base::read_shadow_ptr(this->info_) );
+                if (nullptr != ptr_)
+                {
+                    for (heap_sz_t i = built_; i > 0u; --i)
+                    {
+                        ptr_[i - 1u].~T();
+                    }
+
+                    static_heap::free(ptr_, count_ * sizeof(T));
+                }
+                else
+                {
+                    // do nothing
+                }
             }
 
-            bool pop_if_visited()
+            template <typename... Args>
+            void build(Args&&... args)
             {
-                return ring_base::pop_if_visited(this->info_);
+                new (ptr_ + built_) T(std::forward<Args>(args)...);
+                ++built_;
             }
 
-            bool is_node_visited()
+            // Hands the constructed objects over to the caller
+            T* commit()
             {
-                return ring_base::is_node_visited(this->info_);
+                T* ptr = ptr_;
+                ptr_ = nullptr;
+                return ptr;
             }
 
-            bool unhide_if_hidden()
+        private:
+            T* ptr_;
+            const heap_sz_t count_;
+            heap_sz_t built_;
+        };
+
+        // ===================================================================
+        // Constructs an object in static heap. The returned pointer is empty
+        // if the heap has not enough space
+        // ===================================================================
+        template <typename T, typename... Args>
+        std::enable_if_t<!std::is_array_v<T>, heap_ptr<T>> make_heap(Args&&... args)
+        {
+            static_assert(alignof(T) <= CEL_STATIC_HEAP_ALIGN, "Type alignment exceeds alignment of static heap");
+            static_assert(sizeof(T) <= static_cast<heap_sz_t>(~0u), "Type size does not fit heap_sz_t");
+
+            T *ptr = nullptr;
+
+            void *p = static_heap::alloc(sizeof(T));
+            if (nullptr != p)
+            {
+                heap_build_guard<T> guard(p, 1u);
+                guard.build(std::forward<Args>(args)...);
+                ptr = guard.commit();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return heap_ptr<T>(ptr);
+        }
+
+        // ===================================================================
+        // Constructs an array of n value-initialized objects in static heap
+        // ===================================================================
+        template <typename T>
+        std::enable_if_t<std::is_array_v<T> && (0u == std::extent_v<T>), heap_ptr<T>> make_heap(heap_sz_t n)
+        {
+            using elem_t = std::remove_extent_t<T>;
+
+            static_assert(alignof(elem_t) <= CEL_STATIC_HEAP_ALIGN, "Type alignment exceeds alignment of static heap");
+            static_assert(sizeof(elem_t) <= static_cast<heap_sz_t>(~0u), "Type size does not fit heap_sz_t");
+
+            elem_t *ptr = nullptr;
+
+            if ((0u != n) && ((static_cast<std::uint32_t>(n) * sizeof(elem_t)) <= static_cast<heap_sz_t>(~0u)))
+            {
+                void *p = static_heap::alloc(n * sizeof(elem_t));
+                if (nullptr != p)
+                {
+                    heap_build_guard<elem_t> guard(p, n);
+                    for (heap_sz_t i = 0u; i < n; ++i)
+                    {
+                        guard.build();
+                    }
+                    ptr = guard.commit();
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return heap_ptr<T>(ptr, n);
+        }
+
+        // ===================================================================
+        // Ring buffer base class
+        // ===================================================================
+        class ring_base
+        {
+        public:
+            using span_t = std::uint16_t;
+
+            struct ring_info
+            {
+                // stride is the distance between elements including their features,
+                // zero means elements are packed
+                ring_info(std::uint8_t* ptr, span_t sz, span_t elem_size, bool infinite = false, span_t stride = 0u)
+                                                        : ptr_buff(ptr),
+                                                        size(sz),
+                                                        elem_size(elem_size),
+                                                        stride(0u != stride ? stride : elem_size + sizeof(feature_t)),
+                                                        infinite(infinite)
+                {
+                    head = 0u;
+                    tail = 0u;
+                    n = 0u;
+                }
+
+                std::uint8_t * const ptr_buff;
+                span_t head;
+                span_t tail;
+                span_t n;
+                const span_t size;
+                const span_t elem_size;
+                const span_t stride;
+                const bool infinite;
+            };
+
+            struct feature_t
+            {
+                bool b_visited;
+                bool b_hidden;
+            };
+
+            // Storage of one element in the ring buffer
+            template <typename T>
+            struct slot_t
+            {
+                T obj;
+                feature_t feature;
+            };
+
+            ring_base(const ring_base&)              = delete;
+            ring_base(ring_base&&)                   = delete;
+
+            ring_base& operator = (const ring_base&) = delete;
+            ring_base& operator = (ring_base&&)      = delete;
+
+            static span_t    			get_count        (const ring_info& info);
+
+            static void      			reset            (ring_info& info);
+
+            static bool      			push             (ring_info& info, const std::uint8_t* ptr_data, bool b_hidden = false);
+
+            static bool      			pop              (ring_info& info, std::uint8_t* ptr_data);
+
+            static span_t    			push_n           (ring_info& info, const std::uint8_t* ptr_data, span_t n_elems);
+
+            static span_t    			pop_n            (ring_info& info, std::uint8_t* ptr_data, span_t n_elems);
+
+            static bool      			read_shadow      (ring_info& info, std::uint8_t* ptr_data);
+
+            static const std::uint8_t*  read_shadow_ptr  (ring_info& info);
+
+            static bool      			pop_if_visited   (ring_info& info);
+
+            static bool      			is_node_visited  (ring_info& info);
+
+            static bool      			unhide_if_hidden (ring_info& info);
+
+            // Returns i-th oldest element, hidden or not, without marking it
+            static const std::uint8_t*  peek_at          (const ring_info& info, span_t i);
+
+        protected:
+
+            explicit ring_base()
+            {
+            }
+
+        private:
+
+            enum class endpoint : std::uint8_t {Head, Tail};
+
+            static constexpr std::uint8_t feature_size_ = sizeof(feature_t);
+
+            static bool sanity_check(ring_info& info, bool b_read = true);
+
+            static std::uint8_t* ptr_to_end(const ring_info& info, endpoint pnt);
+
+            static feature_t* ptr_elem_feature(const ring_info& info, std::uint8_t* ptr_elem)
+            {
+                return reinterpret_cast<feature_t*>(ptr_elem + info.elem_size);
+            }
+
+        };
+
+        // ===================================================================
+        // Elements stored in ring buffer storage, split in two contiguous
+        // parts when they wrap around the end of the buffer
+        // ===================================================================
+        template <typename T>
+        struct ring_region
+        {
+            T* ptr[2];
+            ring_base::span_t count[2];
+
+            ring_base::span_t size() const
+            {
+                return static_cast<ring_base::span_t>(count[0] + count[1]);
+            }
+        };
+
+        // ===================================================================
+        // Lock-free ring buffer for a single producer and a single consumer.
+        // The producer only writes head and the consumer only writes tail,
+        // so no interrupt masking and no shared element counter are needed.
+        // Indices run over twice the size to tell the full ring from the
+        // empty one without wasting a slot. With b_cached each side keeps
+        // a copy of the other side's index and reloads it only when the
+        // ring looks full or empty, so the cache line of the other side is
+        // read rarely; without it the other index is loaded on every call
+        // ===================================================================
+        template <bool b_cached>
+        class basic_ring_spsc
+        {
+        public:
+            using span_t = ring_base::span_t;
+
+            // indices run over twice the size to tell a full ring from an empty one
+            static constexpr span_t max_size = 0x7FFFu;
+
+            static constexpr bool lock_free = true;
+
+            struct ring_info
+            {
+                // infinite mode is not supported as the producer cannot discard elements,
+                // so requesting it leaves the ring not good like a size out of range
+                ring_info(std::uint8_t* ptr, span_t sz, span_t elem_size, bool b_infinite = false, span_t = 0u)
+                                                        : ptr_buff(((sz <= max_size) && !b_infinite) ? ptr : nullptr),
+                                                        size(sz),
+                                                        elem_size(elem_size),
+                                                        head(0u),
+                                                        tail_cache(0u),
+                                                        tail(0u),
+                                                        head_cache(0u)
+                {
+                }
+
+                std::uint8_t * const ptr_buff;
+                const span_t size;
+                const span_t elem_size;
+
+                // written by producer, tail_cache is the last tail seen by producer
+                // and shares the padding of head, so it costs no memory when unused
+                alignas(CEL_CACHE_LINE_SIZE) std::atomic<span_t> head;
+                span_t tail_cache;
+
+                // written by consumer, head_cache is the last head seen by consumer
+                alignas(CEL_CACHE_LINE_SIZE) std::atomic<span_t> tail;
+                span_t head_cache;
+
+                static constexpr bool infinite = false;
+            };
+
+            template <typename T>
+            using slot_t = T;
+
+            basic_ring_spsc(const basic_ring_spsc&)              = delete;
+            basic_ring_spsc(basic_ring_spsc&&)                   = delete;
+
+            basic_ring_spsc& operator = (const basic_ring_spsc&) = delete;
+            basic_ring_spsc& operator = (basic_ring_spsc&&)      = delete;
+
+            static span_t               get_count        (const ring_info& info);
+
+            // Not thread safe, call when neither producer nor consumer is active
+            static void                 reset            (ring_info& info);
+
+            static bool                 push             (ring_info& info, const std::uint8_t* ptr_data);
+
+            static bool                 pop              (ring_info& info, std::uint8_t* ptr_data);
+
+            static span_t               push_n           (ring_info& info, const std::uint8_t* ptr_data, span_t n_elems);
+
+            static span_t               pop_n            (ring_info& info, std::uint8_t* ptr_data, span_t n_elems);
+
+            // Copies the oldest element without removing it
+            static bool                 read_shadow      (ring_info& info, std::uint8_t* ptr_data);
+
+            static const std::uint8_t*  read_shadow_ptr  (ring_info& info);
+
+            // Free slots to be written in place by producer, made visible by commit
+            static ring_region<std::uint8_t> reserve     (ring_info& info, span_t n_elems);
+
+            static span_t               commit           (ring_info& info, span_t n_elems);
+
+            // Oldest elements to be read in place by consumer, released by consume
+            static ring_region<const std::uint8_t> peek  (ring_info& info, span_t n_elems);
+
+            static span_t               consume          (ring_info& info, span_t n_elems);
+
+            // Returns i-th oldest element, must be called by consumer only
+            static const std::uint8_t*  peek_at          (const ring_info& info, span_t i);
+
+        protected:
+
+            explicit basic_ring_spsc()
+            {
+            }
+
+        private:
+
+            static span_t count(const ring_info& info, span_t head, span_t tail)
+            {
+                return (head >= tail) ? (head - tail) : static_cast<span_t>(2u * info.size - (tail - head));
+            }
+
+            // Free slots seen by producer, a cached tail is reloaded only if there are fewer than wanted
+            static span_t free_space(ring_info& info, span_t head, span_t wanted)
+            {
+                span_t space = 0u;
+
+                if constexpr (b_cached)
+                {
+                    space = info.size - count(info, head, info.tail_cache);
+                    if (space < wanted)
+                    {
+                        info.tail_cache = info.tail.load(std::memory_order_acquire);
+                        space = info.size - count(info, head, info.tail_cache);
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    (void)wanted;
+                    space = info.size - count(info, head, info.tail.load(std::memory_order_acquire));
+                }
+
+                return space;
+            }
+
+            // Elements seen by consumer, a cached head is reloaded only if there are fewer than wanted
+            static span_t ready_count(ring_info& info, span_t tail, span_t wanted)
+            {
+                span_t avail = 0u;
+
+                if constexpr (b_cached)
+                {
+                    avail = count(info, info.head_cache, tail);
+                    if (avail < wanted)
+                    {
+                        info.head_cache = info.head.load(std::memory_order_acquire);
+                        avail = count(info, info.head_cache, tail);
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    (void)wanted;
+                    avail = count(info, info.head.load(std::memory_order_acquire), tail);
+                }
+
+                return avail;
+            }
+
+            static span_t next(const ring_info& info, span_t idx)
+            {
+                return (++idx < 2u * info.size) ? idx : 0u;
+            }
+
+            static std::uint8_t* ptr_elem(const ring_info& info, span_t idx)
+            {
+                return info.ptr_buff + ((idx < info.size) ? idx : (idx - info.size)) * info.elem_size;
+            }
+
+            static ring_region<std::uint8_t> region(const ring_info& info, span_t idx, span_t n_elems);
+        };
+
+        // Reloads the other index on every call, which is cheaper when the
+        // ring is mostly empty or full, as the cached copy would miss anyway
+        using ring_spsc        = basic_ring_spsc<false>;
+
+        // Reads the cache line of the other side only when the ring looks
+        // full or empty, for a producer and a consumer on different cores
+        using ring_spsc_cached = basic_ring_spsc<true>;
+
+        // ===================================================================
+        // Bounded lock-free ring buffer for multiple producers and multiple
+        // consumers. Every slot has a sequence number telling whether it is
+        // ready for writing or for reading at the current position, so that
+        // producers and consumers only compete for their own index (Vyukov).
+        // The size must be a power of two
+        // ===================================================================
+        class ring_mpmc
+        {
+        public:
+            using span_t = ring_base::span_t;
+            using seq_t  = std::uint32_t;
+
+            static constexpr bool lock_free = true;
+
+            struct ring_info
+            {
+                ring_info(std::uint8_t* ptr, span_t sz, span_t elem_size, bool b_infinite = false, span_t stride = 0u);
+
+                std::uint8_t * const ptr_buff;
+                const span_t size;
+                const span_t elem_size;
+                const span_t stride;
+
+                alignas(CEL_CACHE_LINE_SIZE) std::atomic<seq_t> head;
+
+                alignas(CEL_CACHE_LINE_SIZE) std::atomic<seq_t> tail;
+
+                // infinite mode is not supported, requesting it leaves the ring not good
+                static constexpr bool infinite = false;
+            };
+
+            // the sequence number follows the object so that its offset
+            // is known from the object size only
+            template <typename T>
+            struct slot_t
+            {
+                static_assert(alignof(std::atomic<seq_t>) <= CEL_STATIC_HEAP_ALIGN, "Sequence numbers would be misaligned on static heap, increase CEL_STATIC_HEAP_ALIGN");
+
+                T obj;
+                std::atomic<seq_t> seq;
+            };
+
+            ring_mpmc(const ring_mpmc&)              = delete;
+            ring_mpmc(ring_mpmc&&)                   = delete;
+
+            ring_mpmc& operator = (const ring_mpmc&) = delete;
+            ring_mpmc& operator = (ring_mpmc&&)      = delete;
+
+            // Snapshot only, as producers and consumers may be active meanwhile
+            static span_t               get_count        (const ring_info& info);
+
+            // Not thread safe, call when neither producers nor consumers are active
+            static void                 reset            (ring_info& info);
+
+            static bool                 push             (ring_info& info, const std::uint8_t* ptr_data);
+
+            static bool                 pop              (ring_info& info, std::uint8_t* ptr_data);
+
+        protected:
+
+            explicit ring_mpmc()
+            {
+            }
+
+        private:
+
+            static std::atomic<seq_t>* ptr_seq(const ring_info& info, std::uint8_t* ptr_elem)
+            {
+                constexpr span_t seq_align = alignof(std::atomic<seq_t>);
+                return reinterpret_cast<std::atomic<seq_t>*>(ptr_elem + ((info.elem_size + (seq_align - 1u)) & ~(seq_align - 1u)));
+            }
+
+            static std::uint8_t* ptr_elem(const ring_info& info, seq_t pos)
+            {
+                return info.ptr_buff + (pos & (info.size - 1u)) * info.stride;
+            }
+        };
+
+        // ===================================================================
+        // Ring buffer with the features of ring_base and compile time capacity
+        // N, which must be a power of two. The indices run freely and are
+        // wrapped by masking, so the element count is their difference.
+        // Slots are padded to a power of two, so that the offset of a slot
+        // is a shift of its index, and the calls are inlined
+        // ===================================================================
+        template <ring_base::span_t N>
+        class ring_pow2
+        {
+            static_assert((N > 0u) && (0u == (N & (N - 1u))) && (N <= 0x8000u), "Capacity must be a power of two fitting span_t");
+
+            static constexpr std::size_t pow2_ceil(std::size_t size)
+            {
+                std::size_t pow2 = 1u;
+                while (pow2 < size)
+                {
+                    pow2 <<= 1u;
+                }
+
+                return pow2;
+            }
+
+            template <typename T>
+            struct padded_slot_t
+            {
+                ring_base::slot_t<T> slot;
+                std::uint8_t pad[pow2_ceil(sizeof(ring_base::slot_t<T>)) - sizeof(ring_base::slot_t<T>)];
+            };
+
+        public:
+            using span_t    = ring_base::span_t;
+            using feature_t = ring_base::feature_t;
+
+            // allocators take the size of the ring from here
+            static constexpr span_t capacity = N;
+
+            struct ring_info
+            {
+                // the size is always N, the buffer is not usable unless the stride is a power of two
+                ring_info(std::uint8_t* ptr, span_t, span_t elem_size, bool b_infinite = false, span_t stride = 0u)
+                                                        : ptr_buff(((0u != stride) && (0u == (stride & (stride - 1u)))) ? ptr : nullptr),
+                                                        size(N),
+                                                        elem_size(elem_size),
+                                                        shift(log2(stride)),
+                                                        infinite(b_infinite)
+                {
+                    head = 0u;
+                    tail = 0u;
+                }
+
+                std::uint8_t * const ptr_buff;
+                span_t head;
+                span_t tail;
+                const span_t size;
+                const span_t elem_size;
+                const std::uint8_t shift;
+                const bool infinite;
+
+            private:
+
+                static constexpr std::uint8_t log2(span_t stride)
+                {
+                    std::uint8_t n = 0u;
+                    while ((static_cast<std::uint32_t>(stride) >> n) > 1u)
+                    {
+                        ++n;
+                    }
+
+                    return n;
+                }
+            };
+
+            template <typename T>
+            using slot_t = std::conditional_t<sizeof(ring_base::slot_t<T>) == pow2_ceil(sizeof(ring_base::slot_t<T>)), ring_base::slot_t<T>, padded_slot_t<T>>;
+
+            ring_pow2(const ring_pow2&)              = delete;
+            ring_pow2(ring_pow2&&)                   = delete;
+
+            ring_pow2& operator = (const ring_pow2&) = delete;
+            ring_pow2& operator = (ring_pow2&&)      = delete;
+
+            static span_t get_count(const ring_info& info)
+            {
+                detail::disable_interrupts();
+                const span_t n = count(info);
+                detail::enable_interrupts();
+
+                return n;
+            }
+
+            static void reset(ring_info& info)
+            {
+                detail::disable_interrupts();
+                info.head = 0u;
+                info.tail = 0u;
+                detail::enable_interrupts();
+            }
+
+            static bool push(ring_info& info, const std::uint8_t* ptr_data, bool b_hidden = false)
+            {
+                bool retval = false;
+
+                if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+                {
+                    detail::disable_interrupts();
+
+                    if ((N == count(info)) && info.infinite)
+                    {
+                        // discard the oldest record even if it is hidden
+                        *feature(info, info.tail) = { false, false };
+                        ++info.tail;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    if (N > count(info))
+                    {
+                        std::memcpy(slot(info, info.head), ptr_data, info.elem_size);
+                        *feature(info, info.head) = { false, b_hidden };
+                        ++info.head;
+
+                        retval = true;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    detail::enable_interrupts();
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+            static bool pop(ring_info& info, std::uint8_t* ptr_data)
+            {
+                return (1u == pop_n(info, ptr_data, 1u));
+            }
+
+            static span_t push_n(ring_info& info, const std::uint8_t* ptr_data, span_t n_elems)
+            {
+                span_t retval = 0u;
+
+                if ((nullptr != info.ptr_buff) && (nullptr != ptr_data))
+                {
+                    detail::disable_interrupts();
+
+                    span_t skip = 0u;
+                    if (info.infinite)
+                    {
+                        if (n_elems > N)
+                        {
+                            // older elements would be overwritten by the newer ones anyway
+                            skip = n_elems - N;
+                            ptr_data += skip * info.elem_size;
+                            n_elems = N;
+                        }
+                        else
+                        {
+                            // do nothing
+                        }
+
+                        if (n_elems > (N - count(info)))
+                        {
+                            info.tail += n_elems - (N - count(info));
+                        }
+                        else
+                        {
+                            // do nothing
+                        }
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    const span_t m = (n_elems < (N - count(info))) ? n_elems : static_cast<span_t>(N - count(info));
+
+                    for (span_t i = 0u; i < m; ++i)
+                    {
+                        std::memcpy(slot(info, info.head), ptr_data, info.elem_size);
+                        *feature(info, info.head) = { false, false };
+                        ptr_data += info.elem_size;
+                        ++info.head;
+                    }
+
+                    detail::enable_interrupts();
+
+                    retval = m + skip;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+            // Stops at the first hidden element, discards the elements if ptr_data is nullptr
+            static span_t pop_n(ring_info& info, std::uint8_t* ptr_data, span_t n_elems)
+            {
+                span_t m = 0u;
+
+                if (nullptr != info.ptr_buff)
+                {
+                    detail::disable_interrupts();
+
+                    while ((m < n_elems) && (count(info) > 0u) && !feature(info, info.tail)->b_hidden)
+                    {
+                        if (nullptr != ptr_data)
+                        {
+                            std::memcpy(ptr_data, slot(info, info.tail), info.elem_size);
+                            ptr_data += info.elem_size;
+                        }
+                        else
+                        {
+                            // just discard the record without returning its copy
+                        }
+
+                        feature(info, info.tail)->b_visited = false;
+                        ++info.tail;
+                        ++m;
+                    }
+
+                    detail::enable_interrupts();
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return m;
+            }
+
+            static bool read_shadow(ring_info& info, std::uint8_t* ptr_data)
+            {
+                bool retval = false;
+
+                if (nullptr != ptr_data)
+                {
+                    detail::disable_interrupts();
+
+                    const std::uint8_t* ptr = shadow(info);
+                    if (nullptr != ptr)
+                    {
+                        std::memcpy(ptr_data, ptr, info.elem_size);
+                        retval = true;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    detail::enable_interrupts();
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+            static const std::uint8_t* read_shadow_ptr(ring_info& info)
+            {
+                detail::disable_interrupts();
+                const std::uint8_t* ptr = shadow(info);
+                detail::enable_interrupts();
+
+                return ptr;
+            }
+
+            static bool pop_if_visited(ring_info& info)
+            {
+                bool retval = false;
+
+                detail::disable_interrupts();
+
+                if ((nullptr != info.ptr_buff) && (count(info) > 0u) && feature(info, info.tail)->b_visited)
+                {
+                    feature(info, info.tail)->b_visited = false;
+                    ++info.tail;
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                detail::enable_interrupts();
+
+                return retval;
+            }
+
+            static bool is_node_visited(ring_info& info)
+            {
+                detail::disable_interrupts();
+                const bool retval = (nullptr != info.ptr_buff) && (count(info) > 0u) && feature(info, info.tail)->b_visited;
+                detail::enable_interrupts();
+
+                return retval;
+            }
+
+            static bool unhide_if_hidden(ring_info& info)
+            {
+                bool retval = false;
+
+                detail::disable_interrupts();
+
+                if ((nullptr != info.ptr_buff) && (count(info) > 0u) && feature(info, info.tail)->b_hidden)
+                {
+                    feature(info, info.tail)->b_hidden = false;
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                detail::enable_interrupts();
+
+                return retval;
+            }
+
+            static const std::uint8_t* peek_at(const ring_info& info, span_t i)
+            {
+                const std::uint8_t* ptr = nullptr;
+
+                detail::disable_interrupts();
+
+                if (i < count(info))
+                {
+                    ptr = slot(info, static_cast<span_t>(info.tail + i));
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                detail::enable_interrupts();
+
+                return ptr;
+            }
+
+        protected:
+
+            explicit ring_pow2()
+            {
+            }
+
+        private:
+
+            static span_t count(const ring_info& info)
+            {
+                return (nullptr != info.ptr_buff) ? static_cast<span_t>(info.head - info.tail) : 0u;
+            }
+
+            static std::uint8_t* slot(const ring_info& info, span_t idx)
+            {
+                return info.ptr_buff + (static_cast<std::size_t>(idx & (N - 1u)) << info.shift);
+            }
+
+            static feature_t* feature(const ring_info& info, span_t idx)
+            {
+                return reinterpret_cast<feature_t*>(slot(info, idx) + info.elem_size);
+            }
+
+            // Returns the oldest element marked as visited or nullptr if it is hidden
+            static const std::uint8_t* shadow(ring_info& info)
+            {
+                const std::uint8_t* ptr = nullptr;
+
+                if ((count(info) > 0u) && !feature(info, info.tail)->b_hidden)
+                {
+                    feature(info, info.tail)->b_visited = true;
+                    ptr = slot(info, info.tail);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return ptr;
+            }
+        };
+
+        // ===================================================================
+        // Ring buffer with the features of ring_base, where the elements are
+        // stored contiguously and their visited and hidden marks are kept in
+        // two bitmaps following the elements. Runs of elements are copied at
+        // once and no padding is added to the elements
+        // ===================================================================
+        class ring_soa
+        {
+        public:
+            using span_t = ring_base::span_t;
+
+            struct ring_info
+            {
+                ring_info(std::uint8_t* ptr, span_t sz, span_t elem_size, bool infinite = false, span_t = 0u);
+
+                std::uint8_t * const ptr_buff;
+                std::uint8_t * const ptr_visited;
+                std::uint8_t * const ptr_hidden;
+                span_t head;
+                span_t tail;
+                span_t n;
+                const span_t size;
+                const span_t elem_size;
+                const bool infinite;
+            };
+
+            template <typename T>
+            using slot_t = T;
+
+            // Number of bytes of storage for sz elements and their marks
+            template <typename T>
+            static constexpr std::size_t storage_size(span_t sz)
+            {
+                return sz * sizeof(T) + 2u * bitmap_size(sz);
+            }
+
+            ring_soa(const ring_soa&)              = delete;
+            ring_soa(ring_soa&&)                   = delete;
+
+            ring_soa& operator = (const ring_soa&) = delete;
+            ring_soa& operator = (ring_soa&&)      = delete;
+
+            static span_t               get_count        (const ring_info& info);
+
+            static void                 reset            (ring_info& info);
+
+            static bool                 push             (ring_info& info, const std::uint8_t* ptr_data, bool b_hidden = false);
+
+            static bool                 pop              (ring_info& info, std::uint8_t* ptr_data);
+
+            static span_t               push_n           (ring_info& info, const std::uint8_t* ptr_data, span_t n_elems);
+
+            static span_t               pop_n            (ring_info& info, std::uint8_t* ptr_data, span_t n_elems);
+
+            static bool                 read_shadow      (ring_info& info, std::uint8_t* ptr_data);
+
+            static const std::uint8_t*  read_shadow_ptr  (ring_info& info);
+
+            static bool                 pop_if_visited   (ring_info& info);
+
+            static bool                 is_node_visited  (ring_info& info);
+
+            static bool                 unhide_if_hidden (ring_info& info);
+
+            static const std::uint8_t*  peek_at          (const ring_info& info, span_t i);
+
+        protected:
+
+            explicit ring_soa()
+            {
+            }
+
+        private:
+
+            static constexpr span_t bitmap_size(span_t sz)
+            {
+                return static_cast<span_t>((sz + 7u) / 8u);
+            }
+
+            static bool get_mark(const std::uint8_t* bitmap, span_t idx)
+            {
+                return (0u != (bitmap[idx >> 3u] & (1u << (idx & 7u))));
+            }
+
+            static void set_mark(std::uint8_t* bitmap, span_t idx, bool b_set)
+            {
+                if (b_set)
+                {
+                    bitmap[idx >> 3u] |= static_cast<std::uint8_t>(1u << (idx & 7u));
+                }
+                else
+                {
+                    bitmap[idx >> 3u] &= static_cast<std::uint8_t>(~(1u << (idx & 7u)));
+                }
+            }
+
+            static void clear_marks(const ring_info& info, std::uint8_t* bitmap, span_t idx, span_t count);
+
+            static span_t count_unmarked(const ring_info& info, const std::uint8_t* bitmap, span_t idx, span_t count);
+
+            static void copy_in(ring_info& info, const std::uint8_t* ptr_data, span_t count);
+
+            static void copy_out(const ring_info& info, std::uint8_t* ptr_data, span_t count);
+
+            static const std::uint8_t* shadow(ring_info& info);
+        };
+
+        // ===================================================================
+        // Plain FIFO ring buffer without visited and hidden marks. The
+        // elements are stored contiguously with no extra bytes, for rings
+        // which only push and pop
+        // ===================================================================
+        class ring_fifo
+        {
+        public:
+            using span_t = ring_base::span_t;
+
+            struct ring_info
+            {
+                ring_info(std::uint8_t* ptr, span_t sz, span_t elem_size, bool infinite = false, span_t = 0u)
+                                                        : ptr_buff(ptr),
+                                                        size(sz),
+                                                        elem_size(elem_size),
+                                                        infinite(infinite)
+                {
+                    head = 0u;
+                    tail = 0u;
+                    n = 0u;
+                }
+
+                std::uint8_t * const ptr_buff;
+                span_t head;
+                span_t tail;
+                span_t n;
+                const span_t size;
+                const span_t elem_size;
+                const bool infinite;
+            };
+
+            template <typename T>
+            using slot_t = T;
+
+            ring_fifo(const ring_fifo&)              = delete;
+            ring_fifo(ring_fifo&&)                   = delete;
+
+            ring_fifo& operator = (const ring_fifo&) = delete;
+            ring_fifo& operator = (ring_fifo&&)      = delete;
+
+            static span_t               get_count        (const ring_info& info);
+
+            static void                 reset            (ring_info& info);
+
+            static bool                 push             (ring_info& info, const std::uint8_t* ptr_data);
+
+            static bool                 pop              (ring_info& info, std::uint8_t* ptr_data);
+
+            static span_t               push_n           (ring_info& info, const std::uint8_t* ptr_data, span_t n_elems);
+
+            static span_t               pop_n            (ring_info& info, std::uint8_t* ptr_data, span_t n_elems);
+
+            // Copies the oldest element without removing it
+            static bool                 read_shadow      (ring_info& info, std::uint8_t* ptr_data);
+
+            static const std::uint8_t*  read_shadow_ptr  (ring_info& info);
+
+            static const std::uint8_t*  peek_at          (const ring_info& info, span_t i);
+
+        protected:
+
+            explicit ring_fifo()
+            {
+            }
+
+        };
+
+        // ===================================================================
+        // Ring buffer allocator class. By default uses manual_heap class to 
+        // allocate buffer from static heap organized by class static_heap
+        // ===================================================================
+        template <typename T, typename engine_t = ring_base>
+        class ring_heap_allocator
+        {
+        public:
+            using engine = engine_t;
+
+            ring_heap_allocator(const ring_heap_allocator&)              = delete;
+            ring_heap_allocator(ring_heap_allocator&&)                   = delete;
+
+            ring_heap_allocator& operator = (const ring_heap_allocator&) = delete;
+            ring_heap_allocator& operator = (ring_heap_allocator&&)      = delete;
+
+            template <typename E = engine, typename = std::enable_if_t<!detail::has_capacity<E>::value>>
+            ring_heap_allocator(ring_base::span_t sz, bool infinite = false) :
+                                        ring_buff_ ( alloc_storage(sz) ),
+                                        info_(ring_buff_, sz, sizeof(T), infinite, sizeof(slot_t))
+            {
+            }
+
+            // Engines of compile time capacity take no size, the flag must be bool
+            // so that a size passed by mistake does not turn on infinite mode
+            template <typename B, typename E = engine, typename = std::enable_if_t<detail::has_capacity<E>::value && std::is_same<B, bool>::value>>
+            explicit ring_heap_allocator(B infinite) :
+                                        ring_buff_ ( alloc_storage(E::capacity) ),
+                                        info_(ring_buff_, E::capacity, sizeof(T), infinite, sizeof(slot_t))
+            {
+            }
+
+            template <typename E = engine, typename = std::enable_if_t<detail::has_capacity<E>::value>>
+            ring_heap_allocator() : ring_heap_allocator(false)
+            {
+            }
+
+            ~ring_heap_allocator()
+            {
+                manual_heap::free(ring_buff_, static_cast<heap_sz_t>(detail::storage_size<engine, T>(info_.size)));
+            }
+
+        private:
+
+            using slot_t = typename engine::template slot_t<T>;
+
+            static std::uint8_t* alloc_storage(ring_base::span_t sz)
+            {
+                const std::size_t size = detail::storage_size<engine, T>(sz);
+
+                return ((sz <= detail::max_ring_size<engine>::value) && (size <= static_cast<heap_sz_t>(~0u))) ?
+                                manual_heap::alloc<std::uint8_t>(static_cast<heap_sz_t>(size)) : nullptr;
+            }
+
+            std::uint8_t * const ring_buff_;
+
+        protected:
+
+            typename engine::ring_info info_;
+        };
+
+        // ===================================================================
+        // Ring buffer allocator class holding the storage of N elements in
+        // itself, so that creation of the ring cannot fail and the ring can
+        // be placed by the linker like any other static object
+        // ===================================================================
+        template <typename T, ring_base::span_t N, typename engine_t = ring_base>
+        class inline_ring_allocator
+        {
+        public:
+            using engine = engine_t;
+
+            inline_ring_allocator(const inline_ring_allocator&)              = delete;
+            inline_ring_allocator(inline_ring_allocator&&)                   = delete;
+
+            inline_ring_allocator& operator = (const inline_ring_allocator&) = delete;
+            inline_ring_allocator& operator = (inline_ring_allocator&&)      = delete;
+
+            explicit inline_ring_allocator(bool infinite = false) :
+                                        info_(ring_buff_.data(), N, sizeof(T), infinite, sizeof(slot_t))
+            {
+            }
+
+        private:
+
+            using slot_t = typename engine::template slot_t<T>;
+
+            static_assert(N <= detail::max_ring_size<engine>::value, "Ring size exceeds the range of the engine");
+
+            template <typename E, bool = detail::has_capacity<E>::value>
+            struct fits_capacity : std::true_type
+            {};
+
+            template <typename E>
+            struct fits_capacity<E, true> : std::integral_constant<bool, N == E::capacity>
+            {};
+
+            static_assert(fits_capacity<engine>::value, "Ring size differs from the capacity of the engine");
+
+            // raw storage, as the elements are copied in by the engine
+            alignas(slot_t) std::array<std::uint8_t, detail::storage_size<engine, T>(N)> ring_buff_;
+
+        protected:
+
+            typename engine::ring_info info_;
+        };
+
+        // ===================================================================
+        // Ring buffer maker class
+        // ===================================================================
+        template <typename T, typename allocator = ring_heap_allocator<T>>
+        class ring_maker :  private allocator
+        {
+            using engine = typename allocator::engine;
+
+        public:
+            // whether reserve, commit, peek and consume are available
+            static constexpr bool in_place = detail::has_in_place<engine>::value;
+
+            ring_maker(const ring_maker&)              = delete;
+            ring_maker(ring_maker&&)                   = delete;
+
+            ring_maker& operator = (const ring_maker&) = delete;
+            ring_maker& operator = (ring_maker&&)      = delete;
+
+            // The arguments are those of the allocator, e.g. size and infinite mode
+            // for ring_heap_allocator or infinite mode only for inline_ring_allocator
+            template <typename... Args>
+            explicit ring_maker(Args&&... args) : allocator(std::forward<Args>(args)...)
+            {
+            }
+
+            bool is_good() const
+            {
+                return (nullptr != this->info_.ptr_buff ? true : false);
+            }
+
+            ring_base::span_t get_count() const
+            {
+                return engine::get_count(this->info_);
+            }
+
+            // Capacity and mode the ring was created with
+            ring_base::span_t get_size() const
+            {
+                return this->info_.size;
+            }
+
+            bool is_infinite() const
+            {
+                return this->info_.infinite;
+            }
+
+            void reset ()
+            {
+                engine::reset(this->info_);
+            }
+
+            bool push(const T& t)
+            {
+                return engine::push(this->info_, reinterpret_cast<const std::uint8_t*>(&t));
+            }
+
+            bool push(const T& t, bool b_hidden)
+            {
+                return engine::push(this->info_, reinterpret_cast<const std::uint8_t*>(&t), b_hidden);
+            }
+
+            bool pop()
+            {
+                return engine::pop(this->info_, nullptr);
+            }
+
+            bool pop(T& t)
+            {
+                return engine::pop(this->info_, reinterpret_cast<std::uint8_t*>(&t));
+            }
+
+            // Pushes up to count elements, returns number of pushed elements
+            ring_base::span_t push_n(const T* ptr, ring_base::span_t count)
+            {
+                return engine::push_n(this->info_, reinterpret_cast<const std::uint8_t*>(ptr), count);
+            }
+
+            // Pops up to count elements into ptr or discards them if ptr is nullptr,
+            // returns number of popped elements
+            ring_base::span_t pop_n(T* ptr, ring_base::span_t count)
+            {
+                return engine::pop_n(this->info_, reinterpret_cast<std::uint8_t*>(ptr), count);
+            }
+
+            // Returns up to count free slots which the producer fills in place,
+            // the slots become visible to the consumer on commit
+            ring_region<T> reserve(ring_base::span_t count)
+            {
+                static_assert(in_place, "The ring class does not provide reserve and commit, e.g. use ring_spsc");
+                return to_region<T>(engine::reserve(this->info_, count));
+            }
+
+            ring_base::span_t commit(ring_base::span_t count)
+            {
+                static_assert(in_place, "The ring class does not provide reserve and commit, e.g. use ring_spsc");
+                return engine::commit(this->info_, count);
+            }
+
+            // Returns up to count oldest elements which the consumer reads in place,
+            // the elements are removed on consume
+            ring_region<const T> peek(ring_base::span_t count)
+            {
+                static_assert(in_place, "The ring class does not provide peek and consume, e.g. use ring_spsc");
+                return to_region<const T>(engine::peek(this->info_, count));
+            }
+
+            ring_base::span_t consume(ring_base::span_t count)
+            {
+                static_assert(in_place, "The ring class does not provide peek and consume, e.g. use ring_spsc");
+                return engine::consume(this->info_, count);
+            }
+
+            // Returns i-th oldest element in place or nullptr if there are not as many
+            const T* peek_at(ring_base::span_t i) const
+            {
+                return reinterpret_cast<const T*>( engine::peek_at(this->info_, i) );
+            }
+
+            // Iterator over the elements from the oldest to the newest. The number of
+            // elements is taken when end is called. The element is looked up once per
+            // increment, so dereferencing costs no critical section
+            class const_iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = T;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const T*;
+                using reference         = const T&;
+
+                const_iterator() : ring_(nullptr), i_(0u), ptr_(nullptr)
+                {
+                }
+
+                const_iterator(const ring_maker& ring, ring_base::span_t i) : ring_(&ring), i_(i), ptr_(ring.peek_at(i))
+                {
+                }
+
+                reference operator * () const
+                {
+                    return *ptr_;
+                }
+
+                pointer operator -> () const
+                {
+                    return ptr_;
+                }
+
+                const_iterator& operator ++ ()
+                {
+                    ++i_;
+                    ptr_ = ring_->peek_at(i_);
+                    return *this;
+                }
+
+                const_iterator operator ++ (int)
+                {
+                    const_iterator it = *this;
+                    ++(*this);
+                    return it;
+                }
+
+                bool operator == (const const_iterator& other) const
+                {
+                    return (i_ == other.i_);
+                }
+
+                bool operator != (const const_iterator& other) const
+                {
+                    return (i_ != other.i_);
+                }
+
+            private:
+                const ring_maker* ring_;
+                ring_base::span_t i_;
+                const T* ptr_;
+            };
+
+            const_iterator begin() const
+            {
+                return const_iterator(*this, 0u);
+            }
+
+            const_iterator end() const
+            {
+                return const_iterator(*this, get_count());
+            }
+
+            bool read_shadow(T& t)
+            {
+                return engine::read_shadow(this->info_, reinterpret_cast<std::uint8_t*>(&t));
+            }
+
+            const T* read_shadow_ptr()
+            {
+                return reinterpret_cast<const T*>( engine::read_shadow_ptr(this->info_) );
+            }
+
+            bool pop_if_visited()
+            {
+                return engine::pop_if_visited(this->info_);
+            }
+
+            bool is_node_visited()
+            {
+                return engine::is_node_visited(this->info_);
+            }
+
+            bool unhide_if_hidden()
+            {
+                return engine::unhide_if_hidden(this->info_);
+            }
+
+        private:
+
+            // Mirrored storage continues past its end, so both parts are returned as one
+            template <typename U, typename B>
+            static ring_region<U> to_region(const ring_region<B>& reg)
+            {
+                return detail::is_mirrored<allocator>::value ?
+                       ring_region<U>{ { reinterpret_cast<U*>(reg.ptr[0]), nullptr }, { static_cast<ring_base::span_t>(reg.count[0] + reg.count[1]), 0u } } :
+                       ring_region<U>{ { reinterpret_cast<U*>(reg.ptr[0]), reinterpret_cast<U*>(reg.ptr[1]) }, { reg.count[0], reg.count[1] } };
+            }
+
+        };
+
+        // ===================================================================
+        // Counters of a ring buffer
+        // ===================================================================
+        struct ring_stats
+        {
+            std::uint32_t pushes;
+            std::uint32_t pops;
+
+            // elements which did not fit in the ring
+            std::uint32_t failed_pushes;
+
+            // oldest elements discarded in infinite mode
+            std::uint32_t overwritten;
+
+            // the highest number of elements seen after a push
+            ring_base::span_t peak;
+
+            // latencies in ticks of the clock, bin i counts the latencies
+            // of bit width i, the last bin also counts the wider ones
+            std::uint32_t latency_max;
+            std::array<std::uint32_t, CEL_RING_LATENCY_BINS> latency_hist;
+        };
+
+        // ===================================================================
+        // Element with the time it was pushed at, stored in the slots of
+        // timed_ring and of monitored_ring with a clock
+        // ===================================================================
+        template <typename T>
+        struct timed_entry
+        {
+            std::uint32_t stamp;
+            T obj;
+        };
+
+        // ===================================================================
+        // Ring buffer maker class counting pushes, pops, failed pushes,
+        // overwritten elements and peak occupancy. If clock is not void,
+        // every element is stamped with clock::now() when pushed, which
+        // must return std::uint32_t ticks, and the time spent in the ring
+        // is collected when it is popped. The stamp is stored in the slot
+        // next to the element, so the allocator is that of timed_entry<T>.
+        // Producer and consumer counters are written by their own side
+        // only, so with thread safe rings they are read as snapshots
+        // ===================================================================
+        template <typename T, typename clock = void, typename allocator = ring_heap_allocator<std::conditional_t<std::is_void_v<clock>, T, timed_entry<T>>>>
+        class monitored_ring : private ring_maker<std::conditional_t<std::is_void_v<clock>, T, timed_entry<T>>, allocator>
+        {
+        public:
+            using entry_t = std::conditional_t<std::is_void_v<clock>, T, timed_entry<T>>;
+
+        private:
+            using maker  = ring_maker<entry_t, allocator>;
+            using span_t = ring_base::span_t;
+
+        public:
+            // the slots also hold the stamps if there is a clock
+            static constexpr bool in_place = maker::in_place && std::is_void_v<clock>;
+
+            monitored_ring(const monitored_ring&)              = delete;
+            monitored_ring(monitored_ring&&)                   = delete;
+
+            monitored_ring& operator = (const monitored_ring&) = delete;
+            monitored_ring& operator = (monitored_ring&&)      = delete;
+
+            // The arguments are those of the allocator
+            template <typename... Args>
+            explicit monitored_ring(Args&&... args) : maker(std::forward<Args>(args)...),
+                                                      stats_{}
+            {
+            }
+
+            using maker::is_good;
+            using maker::get_count;
+            using maker::get_size;
+            using maker::is_infinite;
+            using maker::reset;
+            using maker::is_node_visited;
+            using maker::unhide_if_hidden;
+
+            // The elements with their stamps if there is a clock
+            using maker::peek_at;
+            using typename maker::const_iterator;
+            using maker::begin;
+            using maker::end;
+
+            bool push(const T& t)
+            {
+                const span_t before = maker::is_infinite() ? maker::get_count() : 0u;
+                bool retval = false;
+
+                if constexpr (std::is_void_v<clock>)
+                {
+                    retval = maker::push(t);
+                }
+                else
+                {
+                    retval = maker::push(entry_t{clock::now(), t});
+                }
+
+                on_push(retval ? 1u : 0u, 1u, before);
+
+                return retval;
+            }
+
+            bool push(const T& t, bool b_hidden)
+            {
+                const span_t before = maker::is_infinite() ? maker::get_count() : 0u;
+                bool retval = false;
+
+                if constexpr (std::is_void_v<clock>)
+                {
+                    retval = maker::push(t, b_hidden);
+                }
+                else
+                {
+                    retval = maker::push(entry_t{clock::now(), t}, b_hidden);
+                }
+
+                on_push(retval ? 1u : 0u, 1u, before);
+
+                return retval;
+            }
+
+            bool pop()
+            {
+                bool retval = false;
+
+                if constexpr (std::is_void_v<clock>)
+                {
+                    retval = maker::pop();
+                    on_pop(retval ? 1u : 0u);
+                }
+                else
+                {
+                    retval = pop_stamped(nullptr, clock::now());
+                }
+
+                return retval;
+            }
+
+            bool pop(T& t)
+            {
+                bool retval = false;
+
+                if constexpr (std::is_void_v<clock>)
+                {
+                    retval = maker::pop(t);
+                    on_pop(retval ? 1u : 0u);
+                }
+                else
+                {
+                    retval = pop_stamped(&t, clock::now());
+                }
+
+                return retval;
+            }
+
+            // With a clock the elements are stamped and pushed one by one
+            span_t push_n(const T* ptr, span_t count)
+            {
+                const span_t before = maker::is_infinite() ? maker::get_count() : 0u;
+                span_t m = 0u;
+
+                if constexpr (std::is_void_v<clock>)
+                {
+                    m = maker::push_n(ptr, count);
+                }
+                else
+                {
+                    const std::uint32_t now = clock::now();
+                    while ((m < count) && maker::push(entry_t{now, ptr[m]}))
+                    {
+                        ++m;
+                    }
+                }
+
+                on_push(m, count, before);
+
+                return m;
+            }
+
+            // With a clock the elements are popped one by one to collect their latencies
+            span_t pop_n(T* ptr, span_t count)
+            {
+                span_t m = 0u;
+
+                if constexpr (std::is_void_v<clock>)
+                {
+                    m = maker::pop_n(ptr, count);
+                    on_pop(m);
+                }
+                else
+                {
+                    const std::uint32_t now = clock::now();
+                    while ((m < count) && pop_stamped((nullptr != ptr) ? (ptr + m) : nullptr, now))
+                    {
+                        ++m;
+                    }
+                }
+
+                return m;
+            }
+
+            // Elements are written and read in place only without a clock,
+            // since the slots also hold the stamps otherwise
+            ring_region<T> reserve(span_t count)
+            {
+                static_assert(std::is_void_v<clock>, "Slots of a ring with a clock hold stamps, push the elements instead");
+                return maker::reserve(count);
+            }
+
+            span_t commit(span_t count)
+            {
+                static_assert(std::is_void_v<clock>, "Slots of a ring with a clock hold stamps, push the elements instead");
+
+                const span_t m = maker::commit(count);
+                on_push(m, count, 0u);
+
+                return m;
+            }
+
+            ring_region<const T> peek(span_t count)
+            {
+                static_assert(std::is_void_v<clock>, "Slots of a ring with a clock hold stamps, pop the elements instead");
+                return maker::peek(count);
+            }
+
+            span_t consume(span_t count)
+            {
+                static_assert(std::is_void_v<clock>, "Slots of a ring with a clock hold stamps, pop the elements instead");
+
+                const span_t m = maker::consume(count);
+                on_pop(m);
+
+                return m;
+            }
+
+            bool read_shadow(T& t)
+            {
+                const T* ptr = read_shadow_ptr();
+
+                if (nullptr != ptr)
+                {
+                    t = *ptr;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return (nullptr != ptr);
+            }
+
+            const T* read_shadow_ptr()
+            {
+                const T* ptr = nullptr;
+
+                if constexpr (std::is_void_v<clock>)
+                {
+                    ptr = maker::read_shadow_ptr();
+                }
+                else
+                {
+                    const entry_t* ptr_entry = maker::read_shadow_ptr();
+                    ptr = (nullptr != ptr_entry) ? &ptr_entry->obj : nullptr;
+                }
+
+                return ptr;
+            }
+
+            bool pop_if_visited()
+            {
+                bool retval = false;
+
+                if constexpr (std::is_void_v<clock>)
+                {
+                    retval = maker::pop_if_visited();
+                    on_pop(retval ? 1u : 0u);
+                }
+                else
+                {
+                    // the stamp is taken before the slot is released
+                    const entry_t* ptr_entry = maker::peek_at(0u);
+                    const std::uint32_t stamp = (nullptr != ptr_entry) ? ptr_entry->stamp : 0u;
+
+                    retval = maker::pop_if_visited();
+
+                    if (retval)
+                    {
+                        on_pop(1u);
+                        add_latency(clock::now() - stamp);
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+
+                return retval;
+            }
+
+            const ring_stats& stats() const
+            {
+                return stats_;
+            }
+
+            void reset_stats()
+            {
+                stats_ = ring_stats{};
+            }
+
+        private:
+
+            void on_push(span_t m, span_t count, span_t before)
+            {
+                stats_.pushes += m;
+                stats_.failed_pushes += static_cast<span_t>(count - m);
+
+                if (m > 0u)
+                {
+                    const span_t after = maker::get_count();
+
+                    // in infinite mode the ring keeps its count while discarding the oldest elements
+                    if (maker::is_infinite() && ((before + m) > after))
+                    {
+                        stats_.overwritten += static_cast<std::uint32_t>(before + m - after);
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    stats_.peak = (after > stats_.peak) ? after : stats_.peak;
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+
+            void on_pop(span_t m)
+            {
+                stats_.pops += m;
+            }
+
+            // Pops the oldest element into ptr or discards it if ptr is nullptr,
+            // and collects the time it spent in the ring till now
+            bool pop_stamped(T* ptr, std::uint32_t now)
+            {
+                entry_t entry;
+                const bool retval = maker::pop(entry);
+
+                if (retval)
+                {
+                    if (nullptr != ptr)
+                    {
+                        *ptr = entry.obj;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    on_pop(1u);
+                    add_latency(now - entry.stamp);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+            void add_latency(std::uint32_t latency)
+            {
+                std::uint32_t bin = 0u;
+                for (std::uint32_t v = latency; (v > 0u) && (bin < (CEL_RING_LATENCY_BINS - 1u)); v >>= 1u)
+                {
+                    ++bin;
+                }
+
+                ++stats_.latency_hist[bin];
+                stats_.latency_max = (latency > stats_.latency_max) ? latency : stats_.latency_max;
+            }
+
+            ring_stats stats_;
+        };
+
+        // ===================================================================
+        // Priority queue of Levels rings of Depth elements each, level 0
+        // has the highest priority. A bitmap tells which levels may hold
+        // elements, so pop goes straight to the highest non-empty level
+        // instead of polling every ring. The bitmap is atomic, the bit of a
+        // level is set after a push and cleared only after the ring is seen
+        // empty, and the ring is checked again after the clearing, so a bit
+        // may be set for an empty ring but a pushed element is not missed
+        // ===================================================================
+        template <typename T, std::uint8_t Levels, ring_base::span_t Depth, typename engine = ring_base>
+        class priority_ring
+        {
+            static_assert((Levels > 0u) && (Levels <= 32u), "Levels must fit the bitmap");
+
+            using span_t = ring_base::span_t;
+            using level_ring_t = ring_maker<T, inline_ring_allocator<T, Depth, engine>>;
+
+        public:
+            priority_ring(const priority_ring&)              = delete;
+            priority_ring(priority_ring&&)                   = delete;
+
+            priority_ring& operator = (const priority_ring&) = delete;
+            priority_ring& operator = (priority_ring&&)      = delete;
+
+            priority_ring() : bitmap_(0u)
+            {
+            }
+
+            // Number of elements of all levels
+            span_t get_count() const
+            {
+                span_t n = 0u;
+                for (const level_ring_t& ring : levels_)
+                {
+                    n += ring.get_count();
+                }
+
+                return n;
+            }
+
+            span_t get_count(std::uint8_t level) const
+            {
+                return (level < Levels) ? levels_[level].get_count() : 0u;
+            }
+
+            // Not thread safe, call when neither producer nor consumer is active
+            void reset()
+            {
+                for (level_ring_t& ring : levels_)
+                {
+                    ring.reset();
+                }
+
+                bitmap_.store(0u, std::memory_order_relaxed);
+            }
+
+            bool push(const T& t, std::uint8_t level)
+            {
+                bool retval = false;
+
+                if (level < Levels)
+                {
+                    retval = levels_[level].push(t);
+                    if (retval)
+                    {
+                        set_bit(level);
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+            // Pops the oldest element of the highest non-empty level
+            bool pop(T& t)
+            {
+                std::uint8_t level = 0u;
+                return pop(t, level);
+            }
+
+            // Same, also returns the level the element was popped from
+            bool pop(T& t, std::uint8_t& level)
+            {
+                bool retval = false;
+
+                std::uint32_t bitmap = bitmap_.load(std::memory_order_acquire);
+
+                while ((0u != bitmap) && !retval)
+                {
+                    const std::uint8_t lvl = lowest_bit(bitmap);
+
+                    retval = levels_[lvl].pop(t);
+                    if (retval)
+                    {
+                        level = lvl;
+                    }
+                    else
+                    {
+                        clear_bit(lvl);
+
+                        // a push may have come between the pop and the clearing,
+                        // then its element is seen or its bit is set again
+                        if (0u != levels_[lvl].get_count())
+                        {
+                            set_bit(lvl);
+                        }
+                        else
+                        {
+                            bitmap &= ~(1u << lvl);
+                        }
+                    }
+                }
+
+                return retval;
+            }
+
+        private:
+
+            static std::uint8_t lowest_bit(std::uint32_t bitmap)
+            {
+#if defined (__GNUC__)
+                return static_cast<std::uint8_t>(__builtin_ctz(bitmap));
+#else
+                std::uint8_t n = 0u;
+                while (0u == (bitmap & 1u))
+                {
+                    bitmap >>= 1u;
+                    ++n;
+                }
+
+                return n;
+#endif
+            }
+
+            // the bits are set and cleared by read-modify-write operations, so
+            // neither side loses an update of the other on any target; the
+            // release of the setting makes the pushed element visible to the
+            // consumer which clears the bit after it
+            void set_bit(std::uint8_t level)
+            {
+                (void)bitmap_.fetch_or(1u << level, std::memory_order_release);
+            }
+
+            void clear_bit(std::uint8_t level)
+            {
+                (void)bitmap_.fetch_and(~(1u << level), std::memory_order_acq_rel);
+            }
+
+            std::array<level_ring_t, Levels> levels_;
+            std::atomic<std::uint32_t> bitmap_;
+        };
+
+        // ===================================================================
+        // Ring buffer passing objects constructed in static heap by their
+        // pointers, so that the cost of push and pop does not depend on
+        // the size of the object. The ring owns the objects between push
+        // and pop, and destroys the ones left in it when reset or when it
+        // goes away. Infinite mode is not supported, as the discarded
+        // objects would never be destroyed
+        // ===================================================================
+        template <typename T, typename allocator = ring_heap_allocator<T*>>
+        class handle_ring : private ring_maker<T*, allocator>
+        {
+            static_assert(!std::is_array_v<T>, "Arrays are not supported");
+
+            using maker = ring_maker<T*, allocator>;
+
+        public:
+            handle_ring(const handle_ring&)              = delete;
+            handle_ring(handle_ring&&)                   = delete;
+
+            handle_ring& operator = (const handle_ring&) = delete;
+            handle_ring& operator = (handle_ring&&)      = delete;
+
+            template <typename... Args>
+            explicit handle_ring(Args&&... args) : maker(std::forward<Args>(args)...)
+            {
+            }
+
+            ~handle_ring()
+            {
+                reset();
+            }
+
+            bool is_good() const
+            {
+                return (maker::is_good() && !maker::is_infinite());
+            }
+
+            using maker::get_count;
+            using maker::get_size;
+
+            // Destroys all objects in the ring, not thread safe
+            void reset()
+            {
+                while (pop())
+                {
+                    // the popped object is destroyed at once
+                }
+            }
+
+            // Takes ownership of the object if pushed, otherwise ptr keeps it
+            bool push(heap_ptr<T>&& ptr)
+            {
+                bool retval = false;
+
+                if (is_good() && static_cast<bool>(ptr))
+                {
+                    retval = maker::push(ptr.get());
+                    if (retval)
+                    {
+                        (void)ptr.release();
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+            // Returns the oldest object, the pointer is empty if the ring is empty.
+            // The object is destroyed with the pointer unless moved elsewhere
+            heap_ptr<T> pop_ptr()
+            {
+                T* ptr = nullptr;
+                return heap_ptr<T>( maker::pop(ptr) ? ptr : nullptr );
+            }
+
+            // Destroys the oldest object
+            bool pop()
+            {
+                T* ptr = nullptr;
+                const bool retval = maker::pop(ptr);
+
+                // the object is destroyed together with its owner
+                heap_ptr<T> owner(retval ? ptr : nullptr);
+
+                return retval;
+            }
+
+            // Returns the oldest object in place or nullptr, the object stays
+            // valid till it is popped
+            T* peek() const
+            {
+                T* const * ptr = maker::peek_at(0u);
+                return (nullptr != ptr) ? *ptr : nullptr;
+            }
+        };
+
+        // ===================================================================
+        // Ring buffer keeping the elements of the last window ticks. Every
+        // element is stamped with clock::now(), which must return
+        // std::uint32_t ticks, and the elements older than the window are
+        // removed on push. Since the stamps grow from the oldest element
+        // to the newest, elements are found by time with binary search.
+        // The stamps are compared by their difference, so a wraparound of
+        // the clock is handled as long as the window is shorter than half
+        // of the clock range
+        // ===================================================================
+        template <typename T, typename clock, typename allocator = ring_heap_allocator<timed_entry<T>>>
+        class timed_ring : private ring_maker<timed_entry<T>, allocator>
+        {
+            static_assert(!detail::is_lock_free<typename allocator::engine>::value,
+                          "The producer removes elements, which lock-free rings do not allow");
+
+            using maker  = ring_maker<timed_entry<T>, allocator>;
+            using span_t = ring_base::span_t;
+
+        public:
+            using entry_t = timed_entry<T>;
+
+            timed_ring(const timed_ring&)              = delete;
+            timed_ring(timed_ring&&)                   = delete;
+
+            timed_ring& operator = (const timed_ring&) = delete;
+            timed_ring& operator = (timed_ring&&)      = delete;
+
+            // The other arguments are those of the allocator
+            template <typename... Args>
+            explicit timed_ring(std::uint32_t window, Args&&... args) : maker(std::forward<Args>(args)...), window_(window)
+            {
+            }
+
+            using maker::is_good;
+            using maker::get_count;
+            using maker::get_size;
+            using maker::reset;
+
+            // Returns i-th oldest element or nullptr if there are not as many
+            const entry_t* peek_at(span_t i) const
+            {
+                return maker::peek_at(i);
+            }
+
+            bool push(const T& t)
+            {
+                return push(t, clock::now());
+            }
+
+            // The stamp must not be older than the stamp of the newest element
+            bool push(const T& t, std::uint32_t stamp)
+            {
+                evict(stamp);
+                return maker::push(entry_t{stamp, t});
+            }
+
+            bool pop(T& t)
+            {
+                entry_t entry;
+                const bool retval = maker::pop(entry);
+
+                if (retval)
+                {
+                    t = entry.obj;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+            bool pop()
+            {
+                return maker::pop();
+            }
+
+            // Removes the elements older than the window at time now
+            void evict(std::uint32_t now)
+            {
+                const entry_t* ptr = maker::peek_at(0u);
+
+                while ((nullptr != ptr) && ((now - ptr->stamp) > window_))
+                {
+                    (void)maker::pop();
+                    ptr = maker::peek_at(0u);
+                }
+            }
+
+            void evict()
+            {
+                evict(clock::now());
+            }
+
+            // Returns the index of the oldest element stamped at or after time t,
+            // or the number of elements if there is none
+            span_t lower_bound(std::uint32_t t) const
+            {
+                span_t first = 0u;
+                span_t n = maker::get_count();
+
+                while (n > 0u)
+                {
+                    const span_t half = n / 2u;
+                    const entry_t* ptr = maker::peek_at(first + half);
+
+                    if ((nullptr != ptr) && (static_cast<std::int32_t>(ptr->stamp - t) < 0))
+                    {
+                        first += half + 1u;
+                        n -= half + 1u;
+                    }
+                    else
+                    {
+                        n = half;
+                    }
+                }
+
+                return first;
+            }
+
+        private:
+            const std::uint32_t window_;
+        };
+
+        // ===================================================================
+        // Ring buffer of variable length records stored contiguously, each
+        // preceded by its length. A record never wraps around the end of
+        // the buffer, the unused end is marked and skipped instead
+        // ===================================================================
+        class record_ring
+        {
+        public:
+            using span_t = ring_base::span_t;
+
+            struct record_t
+            {
+                const std::uint8_t* ptr;
+                span_t len;
+            };
+
+            record_ring(const record_ring&)              = delete;
+            record_ring(record_ring&&)                   = delete;
+
+            record_ring& operator = (const record_ring&) = delete;
+            record_ring& operator = (record_ring&&)      = delete;
+
+            // Allocates size bytes from static heap, including the lengths of records
+            explicit record_ring(span_t size);
+
+            ~record_ring();
+
+            bool is_good() const
+            {
+                return (nullptr != ptr_buff_ ? true : false);
+            }
+
+            // Number of records
+            span_t get_count() const;
+
+            void reset();
+
+            bool push(const void* ptr, span_t len);
+
+            // Returns the oldest record in place or {nullptr, 0} if there is none,
+            // the record stays valid till it is popped
+            record_t peek();
+
+            bool pop();
+
+        private:
+
+            using len_t = span_t;
+
+            static constexpr span_t len_size_    = sizeof(len_t);
+            static constexpr len_t  wrap_marker_ = static_cast<len_t>(~0u);
+
+            void skip_wrap();
+
+            std::uint8_t * const ptr_buff_;
+            const span_t size_;
+            span_t head_;
+            span_t tail_;
+            span_t n_;
+        };
+
+        // ===================================================================
+        // Ring engine delivering every element to all attached consumers.
+        // Each consumer has its own cursor, and the producer overwrites a
+        // slot only after all consumers have passed it. Lock-free for one
+        // producer and one thread per consumer, indices run over twice the
+        // size as in ring_spsc. A consumer attaches by claiming a free
+        // cursor, which the producer places at the head on its next push,
+        // so consumers may attach and detach while the producer is active
+        // ===================================================================
+        class ring_multicast
+        {
+        public:
+            using span_t     = ring_base::span_t;
+            using consumer_t = std::uint8_t;
+
+            static constexpr consumer_t no_consumer = static_cast<consumer_t>(~0u);
+
+            // indices run over twice the size to tell a full ring from an empty one
+            static constexpr span_t max_size = 0x7FFFu;
+
+            static constexpr bool lock_free = true;
+
+            static_assert(CEL_MULTICAST_CONSUMERS <= 32u, "CEL_MULTICAST_CONSUMERS must fit the mask of joining consumers");
+
+            struct ring_info
+            {
+                // infinite mode is not supported as the producer cannot discard
+                // elements of the consumers, so requesting it leaves the ring not good
+                ring_info(std::uint8_t* ptr, span_t sz, span_t elem_size, bool b_infinite = false, span_t = 0u)
+                                                        : ptr_buff(((sz <= max_size) && !b_infinite) ? ptr : nullptr),
+                                                        size(sz),
+                                                        elem_size(elem_size),
+                                                        head(0u),
+                                                        joining(0u),
+                                                        tail_cache(0u)
+                {
+                    for (cursor_t& c : cursors)
+                    {
+                        c.pos.store(0u, std::memory_order_relaxed);
+                        c.state.store(cursor_free, std::memory_order_relaxed);
+                    }
+                }
+
+                struct cursor_t
+                {
+                    alignas(CEL_CACHE_LINE_SIZE) std::atomic<span_t> pos;
+                    std::atomic<std::uint8_t> state;
+                };
+
+                std::uint8_t * const ptr_buff;
+                const span_t size;
+                const span_t elem_size;
+
+                // head is written by producer, joining by attaching consumers, both
+                // are rarely written by others; tail_cache is the last cursor of the
+                // slowest consumer seen by producer
+                alignas(CEL_CACHE_LINE_SIZE) std::atomic<span_t> head;
+                std::atomic<std::uint32_t> joining;
+                span_t tail_cache;
+
+                std::array<cursor_t, CEL_MULTICAST_CONSUMERS> cursors;
+
+                static constexpr bool infinite = false;
+            };
+
+            template <typename T>
+            using slot_t = T;
+
+            ring_multicast(const ring_multicast&)              = delete;
+            ring_multicast(ring_multicast&&)                   = delete;
+
+            ring_multicast& operator = (const ring_multicast&) = delete;
+            ring_multicast& operator = (ring_multicast&&)      = delete;
+
+            // Claims a cursor, returns no_consumer if all CEL_MULTICAST_CONSUMERS are
+            // attached. The consumer receives the elements of the pushes which start
+            // after the call. Any thread may attach
+            static consumer_t           attach           (ring_info& info);
+
+            // Called by consumer id, which must not pop afterwards
+            static void                 detach           (ring_info& info, consumer_t id);
+
+            // Not thread safe, call when neither producer nor consumers are active
+            static void                 reset            (ring_info& info);
+
+            // Called by producer, fails if the slowest consumer has not passed the
+            // slot yet. Without consumers the element is dropped
+            static bool                 push             (ring_info& info, const std::uint8_t* ptr_data);
+
+            // Called by consumer id, with ptr_data set to nullptr the element is discarded
+            static bool                 pop              (ring_info& info, consumer_t id, std::uint8_t* ptr_data);
+
+            // Returns the oldest element of consumer id in place or nullptr, the
+            // element stays valid till the consumer pops it
+            static const std::uint8_t*  peek             (const ring_info& info, consumer_t id);
+
+            // Number of elements not yet popped by consumer id
+            static span_t               get_count        (const ring_info& info, consumer_t id);
+
+        protected:
+
+            explicit ring_multicast()
             {
-                return ring_base::unhide_if_hidden(this->info_);
             }
 
+        private:
+
+            // a cursor is claimed by attach, placed at the head by producer and released by detach
+            static constexpr std::uint8_t cursor_free    = 0u;
+            static constexpr std::uint8_t cursor_joining = 1u;
+            static constexpr std::uint8_t cursor_active  = 2u;
+
+            static span_t count(const ring_info& info, span_t head, span_t tail)
+            {
+                return (head >= tail) ? (head - tail) : static_cast<span_t>(2u * info.size - (tail - head));
+            }
+
+            static span_t next(const ring_info& info, span_t idx)
+            {
+                return (++idx < 2u * info.size) ? idx : 0u;
+            }
+
+            static std::uint8_t* ptr_elem(const ring_info& info, span_t idx)
+            {
+                return info.ptr_buff + ((idx < info.size) ? idx : (idx - info.size)) * info.elem_size;
+            }
+
+            // The cursor of an active consumer, which is valid only if it returns true
+            static bool cursor(const ring_info& info, consumer_t id, span_t& pos)
+            {
+                const bool b_active = (nullptr != info.ptr_buff) && (id < CEL_MULTICAST_CONSUMERS) &&
+                                      (cursor_active == info.cursors[id].state.load(std::memory_order_acquire));
+
+                pos = b_active ? info.cursors[id].pos.load(std::memory_order_relaxed) : 0u;
+
+                return b_active;
+            }
+
+            static void join(ring_info& info, span_t head);
+
+            static span_t slowest(const ring_info& info, span_t head);
+        };
+
+        // ===================================================================
+        // Multicast ring of elements of type T. The allocator must select
+        // ring_multicast, e.g. ring_heap_allocator<T, ring_multicast> or
+        // inline_ring_allocator<T, N, ring_multicast>
+        // ===================================================================
+        template <typename T, typename allocator = ring_heap_allocator<T, ring_multicast>>
+        class multicast_ring : private allocator
+        {
+            using engine = typename allocator::engine;
+
+            static_assert(std::is_same_v<engine, ring_multicast>, "The allocator of multicast_ring must select ring_multicast");
+
+        public:
+            using span_t     = ring_base::span_t;
+            using consumer_t = ring_multicast::consumer_t;
+
+            static constexpr consumer_t no_consumer = ring_multicast::no_consumer;
+
+            multicast_ring(const multicast_ring&)              = delete;
+            multicast_ring(multicast_ring&&)                   = delete;
+
+            multicast_ring& operator = (const multicast_ring&) = delete;
+            multicast_ring& operator = (multicast_ring&&)      = delete;
+
+            // The arguments are those of the allocator, e.g. the size for ring_heap_allocator
+            template <typename... Args>
+            explicit multicast_ring(Args&&... args) : allocator(std::forward<Args>(args)...)
+            {
+            }
+
+            bool is_good() const
+            {
+                return (nullptr != this->info_.ptr_buff ? true : false);
+            }
+
+            span_t get_size() const
+            {
+                return this->info_.size;
+            }
+
+            consumer_t attach()
+            {
+                return engine::attach(this->info_);
+            }
+
+            void detach(consumer_t id)
+            {
+                engine::detach(this->info_, id);
+            }
+
+            void reset()
+            {
+                engine::reset(this->info_);
+            }
+
+            bool push(const T& t)
+            {
+                return engine::push(this->info_, reinterpret_cast<const std::uint8_t*>(&t));
+            }
+
+            bool pop(consumer_t id)
+            {
+                return engine::pop(this->info_, id, nullptr);
+            }
+
+            bool pop(consumer_t id, T& t)
+            {
+                return engine::pop(this->info_, id, reinterpret_cast<std::uint8_t*>(&t));
+            }
+
+            const T* peek(consumer_t id) const
+            {
+                return reinterpret_cast<const T*>( engine::peek(this->info_, id) );
+            }
+
+            span_t get_count(consumer_t id) const
+            {
+                return engine::get_count(this->info_, id);
+            }
         };
     }
 
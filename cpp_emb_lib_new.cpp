@@ -0,0 +1,791 @@
+/*
+ * Copyright 2023 Davit Hakobyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Optional translation unit. When linked into the project, the global operators
+// new and delete are served by the library instead of the C runtime heap:
+// small objects come from pools of fixed size blocks, the rest from static_heap.
+
+#include <new>
+
+#include "misc.hpp"
+#include "cpp_emb_lib.hpp"
+
+#if !defined( ARM_CROSS_COMPILER )
+#include <atomic>
+#include <mutex>
+#endif
+
+// ===================================================================
+// Defines
+// ===================================================================
+
+// Number of bytes reserved for every size class of small objects
+#ifndef CEL_NEW_POOL_SIZE
+#define CEL_NEW_POOL_SIZE       (1024u)
+#endif
+
+// Number of size classes of small objects, the blocks are of 8 bytes
+// and twice as large in every next class, i.e. up to 128 bytes by default
+#ifndef CEL_NEW_POOL_CLASSES
+#define CEL_NEW_POOL_CLASSES    (5u)
+#endif
+
+// Number of released blocks of every size class a thread of a hosted target
+// keeps for its next allocations before returning blocks to the shared pools
+#ifndef CEL_NEW_THREAD_CACHE
+#define CEL_NEW_THREAD_CACHE    (16u)
+#endif
+
+// Every buffer returned by operator new is aligned at least to this value. If
+// CEL_STATIC_HEAP_ALIGN is smaller, heap buffers are over-allocated to align them
+#define CEL_NEW_ALIGN           (__STDCPP_DEFAULT_NEW_ALIGNMENT__)
+
+namespace cel
+{
+    namespace buffer
+    {
+        namespace
+        {
+            // ===================================================================
+            // Pools of fixed size blocks for small objects. Every size class owns
+            // an equal region of a static arena, so the size class of a released
+            // block is known from its address alone. On hosted targets the free
+            // lists are lock-free and every thread keeps a few released blocks of
+            // every class for itself, on MCUs the lists are updated with
+            // interrupts masked
+            // ===================================================================
+            class new_pool
+            {
+            public:
+
+                static void* alloc(std::size_t size, std::size_t align);
+                static bool free(void *p);
+
+            private:
+
+                // blocks are linked by their number counted from 1 in the arena,
+                // 0 ends the list
+                using link_t = std::uint32_t;
+
+                static constexpr std::size_t class_count_ = CEL_NEW_POOL_CLASSES;
+                static constexpr std::size_t block_min_   = 8u;
+                static constexpr std::size_t block_max_   = block_min_ << (class_count_ - 1u);
+                static constexpr std::size_t region_size_ = CEL_NEW_POOL_SIZE;
+
+                static_assert((class_count_ > 0u) && (class_count_ <= 16u), "CEL_NEW_POOL_CLASSES must be from 1 to 16");
+                static_assert(sizeof(link_t) <= block_min_, "Smallest block cannot hold a link");
+                static_assert(0u == (region_size_ % block_max_), "CEL_NEW_POOL_SIZE must be a multiple of the largest block");
+
+#if defined( ARM_CROSS_COMPILER )
+                struct class_t
+                {
+                    link_t free_list;
+                    std::uint32_t used;
+                };
+#else
+                // the head of the free list carries a counter of pops in its upper
+                // half, so that a head popped and pushed back meanwhile (ABA) fails
+                // the compare and exchange
+                struct class_t
+                {
+                    std::atomic<std::uint64_t> free_list;
+                    std::atomic<std::uint32_t> used;
+                };
+#endif
+
+                static link_t link_of(const void *p)
+                {
+                    return static_cast<link_t>((static_cast<const std::uint8_t*>(p) - &arena_[0]) / block_min_) + 1u;
+                }
+
+                static std::uint8_t* block_of(link_t link)
+                {
+                    return &arena_[(link - 1u) * block_min_];
+                }
+
+                static link_t next_of(link_t link)
+                {
+                    link_t next = 0u;
+                    std::memcpy(&next, block_of(link), sizeof(next));
+                    return next;
+                }
+
+                static void* pop(class_t &cls);
+                static void push(class_t &cls, void *p);
+                static void* take_new(class_t &cls, std::size_t idx, std::size_t block);
+
+#if !defined( ARM_CROSS_COMPILER )
+                // Released blocks kept by a thread, which it takes and returns without
+                // atomic operations. Trivially destructible, so it is accessed directly
+                // and stays usable after the thread has returned its blocks on exit
+                struct cache_t
+                {
+                    link_t free_list[class_count_];
+                    std::uint16_t count[class_count_];
+                    std::uint8_t state;
+                };
+
+                static constexpr std::uint8_t cache_new_    = 0u;
+                static constexpr std::uint8_t cache_active_ = 1u;
+                static constexpr std::uint8_t cache_closed_ = 2u;
+
+                // returns the blocks of the cache to the pools when its thread exits
+                struct cache_guard
+                {
+                    ~cache_guard()
+                    {
+                        new_pool::close_cache();
+                    }
+                };
+
+                static bool cache_push(std::size_t idx, void *p);
+                static void close_cache();
+
+                static inline thread_local cache_t cache_ = {};
+#endif
+
+                // blocks of every class are aligned to their size
+                alignas(block_max_) static inline std::uint8_t arena_[class_count_ * region_size_];
+                static inline class_t classes_[class_count_];
+            };
+
+#if defined( ARM_CROSS_COMPILER )
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Removes the first block of the free list or returns nullptr if it is empty
+            *
+            */
+            void* new_pool::pop(class_t &cls)
+            {
+                void *p = nullptr;
+
+                const std::uint32_t primask = detail::save_and_disable_interrupts();
+
+                if (0u != cls.free_list)
+                {
+                    p = block_of(cls.free_list);
+                    cls.free_list = next_of(cls.free_list);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                detail::restore_interrupts(primask);
+
+                return p;
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Adds the block to the front of the free list
+            *
+            */
+            void new_pool::push(class_t &cls, void *p)
+            {
+                const std::uint32_t primask = detail::save_and_disable_interrupts();
+
+                std::memcpy(p, &cls.free_list, sizeof(link_t));
+                cls.free_list = link_of(p);
+
+                detail::restore_interrupts(primask);
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Hands out the next never used block of the class or returns nullptr if
+            *  the region of the class is exhausted
+            *
+            */
+            void* new_pool::take_new(class_t &cls, std::size_t idx, std::size_t block)
+            {
+                void *p = nullptr;
+
+                const std::uint32_t primask = detail::save_and_disable_interrupts();
+
+                if ((cls.used + block) <= region_size_)
+                {
+                    p = &arena_[idx * region_size_ + cls.used];
+                    cls.used += static_cast<std::uint32_t>(block);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                detail::restore_interrupts(primask);
+
+                return p;
+            }
+#else
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Removes the first block of the free list or returns nullptr if it is empty.
+            *  The link of a block popped by another thread meanwhile may be read stale,
+            *  but then the counter of the head has changed and the exchange is retried.
+            *
+            */
+            void* new_pool::pop(class_t &cls)
+            {
+                void *p = nullptr;
+                std::uint64_t head = cls.free_list.load(std::memory_order_acquire);
+
+                while ((0u != static_cast<link_t>(head)) && (nullptr == p))
+                {
+                    const link_t link = static_cast<link_t>(head);
+                    const std::uint64_t count = (head >> 32u) + 1u;
+                    const std::uint64_t next = (count << 32u) | next_of(link);
+
+                    if (cls.free_list.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+                    {
+                        p = block_of(link);
+                    }
+                    else
+                    {
+                        // head is reloaded by the failed exchange
+                    }
+                }
+
+                return p;
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Adds the block to the front of the free list
+            *
+            */
+            void new_pool::push(class_t &cls, void *p)
+            {
+                const link_t link = link_of(p);
+                std::uint64_t head = cls.free_list.load(std::memory_order_relaxed);
+                std::uint64_t next = 0u;
+
+                do
+                {
+                    const link_t first = static_cast<link_t>(head);
+                    std::memcpy(p, &first, sizeof(first));
+                    next = (head & ~static_cast<std::uint64_t>(0xFFFFFFFFu)) | link;
+                }
+                while ( !cls.free_list.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed) );
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Keeps the block in the cache of the calling thread. Returns false if the
+            *  cache of the class is full or the thread is exiting.
+            *
+            */
+            bool new_pool::cache_push(std::size_t idx, void *p)
+            {
+                bool retval = false;
+
+                if (cache_new_ == cache_.state)
+                {
+                    // the guard is created once per thread, so that its destructor runs on exit
+                    static thread_local cache_guard guard;
+                    (void)guard;
+
+                    cache_.state = cache_active_;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                if ((cache_active_ == cache_.state) && (cache_.count[idx] < CEL_NEW_THREAD_CACHE))
+                {
+                    std::memcpy(p, &cache_.free_list[idx], sizeof(link_t));
+                    cache_.free_list[idx] = link_of(p);
+                    ++cache_.count[idx];
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Returns all blocks of the cache of the calling thread to the pools, later
+            *  releases of the thread go to the pools directly
+            *
+            */
+            void new_pool::close_cache()
+            {
+                cache_.state = cache_closed_;
+
+                for (std::size_t idx = 0u; idx < class_count_; ++idx)
+                {
+                    while (0u != cache_.free_list[idx])
+                    {
+                        void *p = block_of(cache_.free_list[idx]);
+                        cache_.free_list[idx] = next_of(cache_.free_list[idx]);
+                        push(classes_[idx], p);
+                    }
+
+                    cache_.count[idx] = 0u;
+                }
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Hands out the next never used block of the class or returns nullptr if
+            *  the region of the class is exhausted
+            *
+            */
+            void* new_pool::take_new(class_t &cls, std::size_t idx, std::size_t block)
+            {
+                void *p = nullptr;
+                std::uint32_t used = cls.used.load(std::memory_order_relaxed);
+
+                while (((used + block) <= region_size_) && (nullptr == p))
+                {
+                    if (cls.used.compare_exchange_weak(used, static_cast<std::uint32_t>(used + block), std::memory_order_relaxed))
+                    {
+                        p = &arena_[idx * region_size_ + used];
+                    }
+                    else
+                    {
+                        // used is reloaded by the failed exchange
+                    }
+                }
+
+                return p;
+            }
+#endif
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Returns a block of the smallest class fitting both size and alignment or
+            *  nullptr if the object is too large or the class is exhausted.
+            *
+            */
+            void* new_pool::alloc(std::size_t size, std::size_t align)
+            {
+                void *p = nullptr;
+
+                std::size_t idx = 0u;
+                std::size_t block = block_min_;
+                while ((block < size || block < align) && (idx < class_count_))
+                {
+                    block <<= 1u;
+                    ++idx;
+                }
+
+                if (idx < class_count_)
+                {
+#if !defined( ARM_CROSS_COMPILER )
+                    if (0u != cache_.free_list[idx])
+                    {
+                        p = block_of(cache_.free_list[idx]);
+                        cache_.free_list[idx] = next_of(cache_.free_list[idx]);
+                        --cache_.count[idx];
+                    }
+                    else
+                    {
+                        p = pop(classes_[idx]);
+                    }
+#else
+                    p = pop(classes_[idx]);
+#endif
+
+                    if (nullptr == p)
+                    {
+                        // never used blocks are handed out in order, so the arena
+                        // needs no initialization
+                        p = take_new(classes_[idx], idx, block);
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return p;
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Returns the block to its class. Returns false if the pointer does not
+            *  belong to the pools.
+            *
+            */
+            bool new_pool::free(void *p)
+            {
+                bool retval = false;
+                std::uint8_t *ptr = static_cast<std::uint8_t*>(p);
+
+                if ((ptr >= &arena_[0]) && (ptr < &arena_[0] + sizeof(arena_)))
+                {
+                    const std::size_t idx = static_cast<std::size_t>(ptr - &arena_[0]) / region_size_;
+
+#if !defined( ARM_CROSS_COMPILER )
+                    if ( !cache_push(idx, p) )
+                    {
+                        push(classes_[idx], p);
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+#else
+                    push(classes_[idx], p);
+#endif
+
+                    retval = true;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+#if defined( ARM_CROSS_COMPILER )
+            // ===================================================================
+            // Single core MCU, masking of interrupts is enough. PRIMASK is
+            // restored instead of enabling interrupts, as a reclaim handler
+            // called by static_heap may delete objects itself
+            // ===================================================================
+            std::uint32_t new_lock()
+            {
+                return detail::save_and_disable_interrupts();
+            }
+
+            void new_unlock(std::uint32_t state)
+            {
+                detail::restore_interrupts(state);
+            }
+#else
+            // ===================================================================
+            // Threads of a hosted target. The lock is recursive, as a reclaim
+            // handler called by static_heap may delete objects itself. The mutex
+            // is created on first use, so it works before static constructors,
+            // and never destroyed, so it works after static destructors
+            // ===================================================================
+            std::recursive_mutex& new_mutex()
+            {
+                alignas(std::recursive_mutex) static std::uint8_t storage[sizeof(std::recursive_mutex)];
+                static std::recursive_mutex * const ptr_mutex = new (storage) std::recursive_mutex();
+
+                return *ptr_mutex;
+            }
+
+            std::uint32_t new_lock()
+            {
+                new_mutex().lock();
+                return 0u;
+            }
+
+            void new_unlock(std::uint32_t)
+            {
+                new_mutex().unlock();
+            }
+#endif
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Returns the alignment actually used for a request, which is never below
+            *  the alignment operator new guarantees
+            *
+            */
+            constexpr std::size_t new_align(std::size_t align)
+            {
+                return (align > CEL_NEW_ALIGN) ? align : CEL_NEW_ALIGN;
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Allocates from pools and falls back to static heap. Alignments stricter than
+            *  the one of static heap are served by over-allocation where the original
+            *  pointer is stored right before the returned buffer.
+            *
+            */
+            void* new_alloc(std::size_t size, std::size_t align = 0u)
+            {
+                if (0u == size)
+                {
+                    // every call must return a distinct pointer
+                    size = 1u;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                align = new_align(align);
+
+                void *p = new_pool::alloc(size, align);
+
+                if (nullptr == p)
+                {
+                    const std::uint32_t state = new_lock();
+
+                    if (align <= CEL_STATIC_HEAP_ALIGN)
+                    {
+                        if (size <= static_cast<heap_sz_t>(~0u))
+                        {
+                            p = static_heap::alloc(static_cast<heap_sz_t>(size));
+                        }
+                        else
+                        {
+                            // do nothing
+                        }
+                    }
+                    else
+                    {
+                        const std::size_t size_raw = size + align + sizeof(void*);
+                        void *p_raw = nullptr;
+
+                        if (size_raw <= static_cast<heap_sz_t>(~0u))
+                        {
+                            p_raw = static_heap::alloc(static_cast<heap_sz_t>(size_raw));
+                        }
+                        else
+                        {
+                            // do nothing
+                        }
+
+                        if (nullptr != p_raw)
+                        {
+                            std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(p_raw) + sizeof(void*);
+                            addr = (addr + (align - 1u)) & ~static_cast<std::uintptr_t>(align - 1u);
+
+                            p = reinterpret_cast<void*>(addr);
+                            std::memcpy(static_cast<std::uint8_t*>(p) - sizeof(void*), &p_raw, sizeof(void*));
+                        }
+                        else
+                        {
+                            // do nothing
+                        }
+                    }
+
+                    new_unlock(state);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return p;
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Releases buffer allocated by new_alloc. Blocks of the pools are returned
+            *  without the lock, heap buffers always go through the sized free of static
+            *  heap.
+            *
+            */
+            void new_free(void *p, std::size_t size = 0u, std::size_t align = 0u)
+            {
+                if (nullptr != p)
+                {
+                    align = new_align(align);
+
+                    if ( !new_pool::free(p) )
+                    {
+                        const std::uint32_t state = new_lock();
+
+                        if (align > CEL_STATIC_HEAP_ALIGN)
+                        {
+                            std::memcpy(&p, static_cast<std::uint8_t*>(p) - sizeof(void*), sizeof(void*));
+
+                            if (0u != size)
+                            {
+                                size += align + sizeof(void*);
+                            }
+                            else
+                            {
+                                // do nothing
+                            }
+                        }
+                        else
+                        {
+                            // do nothing
+                        }
+
+                        // operator delete gets only pointers returned by operator new,
+                        // so the unsized release takes the size from the page instead
+                        // of walking the heap to validate the pointer
+                        if (0u == size)
+                        {
+                            size = static_heap::block_size(p);
+                        }
+                        else
+                        {
+                            // do nothing
+                        }
+
+                        static_heap::free(p, static_cast<heap_sz_t>(size));
+
+                        new_unlock(state);
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+
+            /*----------------------------------------------------------------------------*/
+            /**
+            *  Throwing flavour of new_alloc. Without exceptions the failure is fatal.
+            *
+            */
+            void* new_alloc_or_fail(std::size_t size, std::size_t align = 0u)
+            {
+                void *p = new_alloc(size, align);
+
+                if (nullptr == p)
+                {
+#if defined( __cpp_exceptions )
+                    throw std::bad_alloc();
+#else
+                    ASSERT(false);
+#endif
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return p;
+            }
+        }
+    }
+}
+
+// ===================================================================
+// Replaceable global allocation functions
+// ===================================================================
+
+void* operator new(std::size_t size)
+{
+    return cel::buffer::new_alloc_or_fail(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return cel::buffer::new_alloc_or_fail(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return cel::buffer::new_alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return cel::buffer::new_alloc(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    return cel::buffer::new_alloc_or_fail(size, static_cast<std::size_t>(align));
+}
+
+void* operator new[](std::size_t size, std::align_val_t align)
+{
+    return cel::buffer::new_alloc_or_fail(size, static_cast<std::size_t>(align));
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return cel::buffer::new_alloc(size, static_cast<std::size_t>(align));
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    return cel::buffer::new_alloc(size, static_cast<std::size_t>(align));
+}
+
+// ===================================================================
+// Replaceable global deallocation functions
+// ===================================================================
+
+void operator delete(void *p) noexcept
+{
+    cel::buffer::new_free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    cel::buffer::new_free(p);
+}
+
+void operator delete(void *p, std::size_t size) noexcept
+{
+    cel::buffer::new_free(p, size);
+}
+
+void operator delete[](void *p, std::size_t size) noexcept
+{
+    cel::buffer::new_free(p, size);
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept
+{
+    cel::buffer::new_free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept
+{
+    cel::buffer::new_free(p);
+}
+
+void operator delete(void *p, std::align_val_t align) noexcept
+{
+    cel::buffer::new_free(p, 0u, static_cast<std::size_t>(align));
+}
+
+void operator delete[](void *p, std::align_val_t align) noexcept
+{
+    cel::buffer::new_free(p, 0u, static_cast<std::size_t>(align));
+}
+
+void operator delete(void *p, std::size_t size, std::align_val_t align) noexcept
+{
+    cel::buffer::new_free(p, size, static_cast<std::size_t>(align));
+}
+
+void operator delete[](void *p, std::size_t size, std::align_val_t align) noexcept
+{
+    cel::buffer::new_free(p, size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void *p, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    cel::buffer::new_free(p, 0u, static_cast<std::size_t>(align));
+}
+
+void operator delete[](void *p, std::align_val_t align, const std::nothrow_t&) noexcept
+{
+    cel::buffer::new_free(p, 0u, static_cast<std::size_t>(align));
+}
@@ -0,0 +1,755 @@
+/*
+ * Copyright 2023 Davit Hakobyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <new>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/futex.h>
+#include <unistd.h>
+
+#include "misc.hpp"
+#include "cpp_emb_lib_posix.hpp"
+
+namespace cel
+{
+
+    namespace buffer
+    {
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Opens (or creates if b_create is set) the named shared memory object of
+        *  requested size and maps it into the address space of the process.
+        *
+        */
+        shm_region::shm_region(const char* name, std::size_t size, bool b_create) : ptr_(nullptr), size_(size)
+        {
+            int fd = shm_open(name, b_create ? (O_CREAT | O_RDWR) : O_RDWR, 0600);
+
+            if (fd >= 0)
+            {
+                if (!b_create || (0 == ftruncate(fd, static_cast<off_t>(size))))
+                {
+                    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                    ptr_ = (MAP_FAILED != ptr) ? ptr : nullptr;
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                // the mapping stays valid after closing the descriptor
+                (void)close(fd);
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Unmaps the region. The shared memory object itself persists till unlink.
+        *
+        */
+        shm_region::~shm_region()
+        {
+            if (nullptr != ptr_)
+            {
+                (void)munmap(ptr_, size_);
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Removes the named shared memory object
+        *
+        */
+        bool shm_region::unlink(const char* name)
+        {
+            return (0 == shm_unlink(name));
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Reserves twice the size of address space and maps the same memory file
+        *  into both halves
+        *
+        */
+        mirror_region::mirror_region(std::size_t size) : ptr_(nullptr), size_(size)
+        {
+            const long page = sysconf(_SC_PAGESIZE);
+
+            if ((size > 0u) && (page > 0) && (0u == (size % static_cast<std::size_t>(page))))
+            {
+                int fd = memfd_create("cel_mirror", MFD_CLOEXEC);
+
+                if (fd >= 0)
+                {
+                    if (0 == ftruncate(fd, static_cast<off_t>(size)))
+                    {
+                        void *base = mmap(nullptr, 2u * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+                        if (MAP_FAILED != base)
+                        {
+                            std::uint8_t *ptr = static_cast<std::uint8_t*>(base);
+
+                            void *first  = mmap(ptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+                            void *second = mmap(ptr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+
+                            if ((first == ptr) && (second == (ptr + size)))
+                            {
+                                ptr_ = base;
+                            }
+                            else
+                            {
+                                (void)munmap(base, 2u * size);
+                            }
+                        }
+                        else
+                        {
+                            // do nothing
+                        }
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    // the mappings stay valid after closing the descriptor
+                    (void)close(fd);
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Unmaps both halves
+        *
+        */
+        mirror_region::~mirror_region()
+        {
+            if (nullptr != ptr_)
+            {
+                (void)munmap(ptr_, 2u * size_);
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Initializes a new heap which spans the whole region. Only one process must
+        *  create the heap, the others attach to it.
+        *
+        */
+        shm_heap* shm_heap::create(void* region, std::size_t size)
+        {
+            shm_heap *heap = nullptr;
+
+            const offset_t heap_start = align_size(sizeof(shm_heap));
+
+            if ((nullptr != region) && (size > (heap_start + page_size_)) && (size <= static_cast<offset_t>(~0u)))
+            {
+                heap = new (region) shm_heap();
+
+                pthread_mutexattr_t attr;
+                (void)pthread_mutexattr_init(&attr);
+                (void)pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+                (void)pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+                (void)pthread_mutex_init(&heap->mutex_, &attr);
+                (void)pthread_mutexattr_destroy(&attr);
+
+                heap->heap_start_ = heap_start;
+                heap->heap_end_ = static_cast<offset_t>(size) & ~(heap_align_ - 1u);
+                heap->free_size_ = heap->heap_end_ - heap->heap_start_ - page_size_;
+                heap->root_ = null_offset;
+
+                page_t *page = heap->page_at(heap->heap_start_);
+                page->size = heap->free_size_;
+                page->prev = null_offset;
+                page->free = true;
+
+                // the magic publishes the heap, so it is stored after the header
+                heap->magic_.store(magic_value_, std::memory_order_release);
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return heap;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns the heap previously created in the region or nullptr
+        *
+        */
+        shm_heap* shm_heap::attach(void* region)
+        {
+            shm_heap *heap = static_cast<shm_heap*>(region);
+
+            if ((nullptr == heap) || (magic_value_ != heap->magic_.load(std::memory_order_acquire)))
+            {
+                heap = nullptr;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return heap;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Acquires the process-shared lock. If the previous owner died while holding
+        *  the lock, the heap is taken over only if its page chain is intact, otherwise
+        *  the lock is left unrecoverable and every following call fails.
+        *
+        */
+        bool shm_heap::lock()
+        {
+            bool b_locked = false;
+
+            const int res = pthread_mutex_lock(&mutex_);
+            if (0 == res)
+            {
+                b_locked = true;
+            }
+            else if (EOWNERDEAD == res)
+            {
+                if (recover())
+                {
+                    (void)pthread_mutex_consistent(&mutex_);
+                    b_locked = true;
+                }
+                else
+                {
+                    // unlocking without marking consistent makes the lock unrecoverable
+                    (void)pthread_mutex_unlock(&mutex_);
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return b_locked;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Walks the page chain left by a dead owner. Page sizes must be aligned and
+        *  the chain must end exactly at the heap end. The back links and the free size,
+        *  which the owner might not have updated yet, are rebuilt from the walk.
+        *
+        */
+        bool shm_heap::recover()
+        {
+            bool b_ok = true;
+
+            offset_t off = heap_start_;
+            offset_t prev = null_offset;
+            std::uint32_t free_size = 0u;
+
+            while (b_ok && (off < heap_end_))
+            {
+                page_t *page = page_at(off);
+
+                if (((heap_end_ - off) < page_size_) ||
+                    (page->size > (heap_end_ - off - page_size_)) ||
+                    (0u != (page->size & (heap_align_ - 1u))))
+                {
+                    b_ok = false;
+                }
+                else
+                {
+                    page->prev = prev;
+                    if (page->free)
+                    {
+                        free_size += page->size;
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+
+                    prev = off;
+                    off += page_size_ + page->size;
+                }
+            }
+
+            if (b_ok && (off == heap_end_))
+            {
+                free_size_ = free_size;
+            }
+            else
+            {
+                b_ok = false;
+            }
+
+            return b_ok;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Releases the process-shared lock
+        *
+        */
+        void shm_heap::unlock()
+        {
+            (void)pthread_mutex_unlock(&mutex_);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Allocates a buffer of requested size or returns nullptr if the space is not enough
+        *  to satisfy the request.
+        *
+        */
+        void* shm_heap::alloc(offset_t size)
+        {
+            void *p = nullptr;
+
+            if (lock())
+            {
+                p = alloc_locked(size);
+                unlock();
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return p;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Frees the previously allocated buffer. The page is validated by walking the
+        *  heap as the size of the buffer is not known.
+        *
+        */
+        void shm_heap::free(void *p)
+        {
+            page_t *pg = page_of(p);
+            if ((nullptr != pg) && lock())
+            {
+                offset_t off = heap_start_;
+                while ((off < heap_end_) && (page_at(off) != pg))
+                {
+                    off += page_at(off)->size + page_size_;
+                }
+
+                if ((off < heap_end_) && !pg->free)
+                {
+                    coalesce(pg);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                unlock();
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Frees the previously allocated buffer of known size without walking the heap
+        *
+        */
+        void shm_heap::free(void *p, offset_t size)
+        {
+            page_t *pg = page_of(p);
+            size = align_size(size);
+
+            if ((nullptr != pg) && lock())
+            {
+                if (!pg->free && (pg->size >= size) && ((pg->size - size) <= page_size_))
+                {
+                    coalesce(pg);
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                unlock();
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  First fit allocation, same as of static_heap but with offset links
+        *
+        */
+        void* shm_heap::alloc_locked(offset_t size)
+        {
+            void *p = nullptr;
+
+            size = align_size(size);
+
+            if ((0u != size) && (free_size_ >= (size + page_size_)))
+            {
+                offset_t off = heap_start_;
+                while (off < heap_end_)
+                {
+                    page_t *page = page_at(off);
+                    if (page->free && (page->size >= size))
+                    {
+                        if ((page->size - size) <= page_size_)
+                        {
+                            // the remaining space is too small to split the page
+                            page->free = false;
+                            free_size_ -= page->size;
+                        }
+                        else
+                        {
+                            const offset_t off_new = off + page_size_ + size;
+
+                            page_t *page_next_new = page_at(off_new);
+                            page_next_new->size = page->size - (size + page_size_);
+                            page_next_new->free = true;
+                            page_next_new->prev = off;
+
+                            page->size = size;
+                            page->free = false;
+
+                            page_t *page_next = next_page(page_next_new);
+                            if (nullptr != page_next)
+                            {
+                                page_next->prev = off_new;
+                            }
+                            else
+                            {
+                                // do nothing
+                            }
+
+                            free_size_ -= size + page_size_;
+                        }
+
+                        p = from_offset(off + page_size_);
+                        break;
+                    }
+                    else
+                    {
+                        off += page->size + page_size_;
+                    }
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return p;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Marks the page as free and merges it with its free neighbours
+        *
+        */
+        void shm_heap::coalesce(page_t * const pg)
+        {
+            page_t *page = pg;
+
+            page->free = true;
+            free_size_ += page->size;
+
+            page_t *page_next = next_page(page);
+            if ((nullptr != page_next) && page_next->free)
+            {
+                page->size += page_next->size + page_size_;
+                free_size_ += page_size_;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            page_t *page_prev = page_at(page->prev);
+            if ((nullptr != page_prev) && page_prev->free)
+            {
+                page_prev->size += page->size + page_size_;
+                free_size_ += page_size_;
+                page = page_prev;
+            }
+            else
+            {
+                // do nothing
+            }
+
+            page_next = next_page(page);
+            if (nullptr != page_next)
+            {
+                page_next->prev = to_offset(page);
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Converts page offset to pointer. The offset 0 is the heap itself, thus null.
+        *
+        */
+        shm_heap::page_t* shm_heap::page_at(offset_t off) const
+        {
+            return from_offset<page_t>(off);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns page of the buffer or nullptr if the pointer is outside of the heap
+        *
+        */
+        shm_heap::page_t* shm_heap::page_of(void *p) const
+        {
+            page_t *page = nullptr;
+
+            const std::uint8_t *ptr = static_cast<const std::uint8_t*>(p);
+            if ((ptr >= (base() + heap_start_ + page_size_)) && (ptr < (base() + heap_end_)))
+            {
+                page = page_at(to_offset(p) - page_size_);
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return page;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Returns page following pg or nullptr if pg is the last one
+        *
+        */
+        shm_heap::page_t* shm_heap::next_page(page_t * const pg) const
+        {
+            const offset_t off = to_offset(pg) + page_size_ + pg->size;
+            return (off < heap_end_) ? page_at(off) : nullptr;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Creates the eventfd if requested. It counts as a semaphore, every parked
+        *  consumer gets a count of its own and takes one count when woken, so that no
+        *  consumer takes the wake of another one.
+        *
+        */
+        ring_event::ring_event(bool b_eventfd) : seq_(0u),
+                                                 parked_(0u),
+                                                 fd_(b_eventfd ? eventfd(0u, EFD_CLOEXEC | EFD_NONBLOCK | EFD_SEMAPHORE) : -1)
+        {
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Closes the eventfd
+        *
+        */
+        ring_event::~ring_event()
+        {
+            if (fd_ >= 0)
+            {
+                (void)close(fd_);
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Publishes new elements and wakes the parked consumers. The sequence is
+        *  changed before the number of parked consumers is read, while consumers are
+        *  counted before they read the sequence, so a consumer either sees the elements
+        *  or gets woken. Every push makes a system call while consumers are parked.
+        *
+        */
+        void ring_event::notify()
+        {
+            (void)seq_.fetch_add(1u);
+
+            const std::uint32_t parked = parked_.load();
+
+            if (parked > 0u)
+            {
+                if (fd_ >= 0)
+                {
+                    const std::uint64_t counts = parked;
+                    (void)write(fd_, &counts, sizeof(counts));
+                }
+                else
+                {
+                    (void)syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&seq_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Counts the consumer as parked and returns the current sequence
+        *
+        */
+        std::uint32_t ring_event::prepare()
+        {
+            (void)parked_.fetch_add(1u);
+
+            return seq_.load();
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Sleeps unless the sequence has changed since prepare, then unparks the
+        *  consumer. Counts of the eventfd left by consumers which did not sleep only
+        *  cause spurious wakes later.
+        *
+        */
+        bool ring_event::wait(std::uint32_t seq, int timeout_ms)
+        {
+            bool retval = true;
+
+            if (seq == seq_.load())
+            {
+                if (fd_ >= 0)
+                {
+                    pollfd pfd = { fd_, POLLIN, 0 };
+
+                    retval = (poll(&pfd, 1u, timeout_ms) > 0);
+                    if (retval)
+                    {
+                        // another consumer may have taken the count meanwhile
+                        std::uint64_t value;
+                        (void)read(fd_, &value, sizeof(value));
+                    }
+                    else
+                    {
+                        // do nothing
+                    }
+                }
+                else
+                {
+                    timespec ts = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+
+                    const long res = syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&seq_), FUTEX_WAIT_PRIVATE, seq,
+                                             (timeout_ms >= 0) ? &ts : nullptr, nullptr, 0);
+
+                    retval = !((-1 == res) && (ETIMEDOUT == errno));
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            (void)parked_.fetch_sub(1u);
+
+            return retval;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Unparks the consumer without sleeping
+        *
+        */
+        void ring_event::cancel()
+        {
+            (void)parked_.fetch_sub(1u);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Fills the vector of a region, the empty second part is left out
+        *
+        */
+        static int to_iovec(iovec (&iov)[2], void* ptr0, std::size_t len0, void* ptr1, std::size_t len1)
+        {
+            iov[0].iov_base = ptr0;
+            iov[0].iov_len  = len0;
+            iov[1].iov_base = ptr1;
+            iov[1].iov_len  = len1;
+
+            return (0u != len1) ? 2 : 1;
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Writes both parts of the region with one system call
+        *
+        */
+        ssize_t write_region(int fd, const ring_region<const std::uint8_t>& reg)
+        {
+            iovec iov[2];
+            const int cnt = to_iovec(iov, const_cast<std::uint8_t*>(reg.ptr[0]), reg.count[0], const_cast<std::uint8_t*>(reg.ptr[1]), reg.count[1]);
+
+            return writev(fd, iov, cnt);
+        }
+
+        /*----------------------------------------------------------------------------*/
+        /**
+        *  Reads into both parts of the region with one system call
+        *
+        */
+        ssize_t read_region(int fd, const ring_region<std::uint8_t>& reg)
+        {
+            iovec iov[2];
+            const int cnt = to_iovec(iov, reg.ptr[0], reg.count[0], reg.ptr[1], reg.count[1]);
+
+            return readv(fd, iov, cnt);
+        }
+    }
+
+}
@@ -0,0 +1,526 @@
+/*
+ * Copyright 2023 Davit Hakobyan
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CPP_EMB_LIB_POSIX_HPP_INCLUDED
+#define CPP_EMB_LIB_POSIX_HPP_INCLUDED
+
+// Optional components for POSIX (Linux) targets
+
+#include <cstddef>
+#include <cerrno>
+#include <atomic>
+#include <chrono>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "cpp_emb_lib.hpp"
+
+namespace cel
+{
+    namespace buffer
+    {
+        // ===================================================================
+        // Class for mapping of named POSIX shared memory
+        // ===================================================================
+        class shm_region
+        {
+        public:
+            shm_region(const shm_region&)              = delete;
+            shm_region(shm_region&&)                   = delete;
+
+            shm_region& operator = (const shm_region&) = delete;
+            shm_region& operator = (shm_region&&)      = delete;
+
+            shm_region(const char* name, std::size_t size, bool b_create);
+
+            ~shm_region();
+
+            static bool unlink(const char* name);
+
+            bool is_good() const
+            {
+                return (nullptr != ptr_ ? true : false);
+            }
+
+            void* get() const
+            {
+                return ptr_;
+            }
+
+            std::size_t size() const
+            {
+                return size_;
+            }
+
+        private:
+            void* ptr_;
+            const std::size_t size_;
+        };
+
+        // ===================================================================
+        // Memory mapped twice back to back, so that the bytes past its end
+        // are the bytes of its start. The size must be a multiple of the
+        // page size
+        // ===================================================================
+        class mirror_region
+        {
+        public:
+            mirror_region(const mirror_region&)              = delete;
+            mirror_region(mirror_region&&)                   = delete;
+
+            mirror_region& operator = (const mirror_region&) = delete;
+            mirror_region& operator = (mirror_region&&)      = delete;
+
+            explicit mirror_region(std::size_t size);
+
+            ~mirror_region();
+
+            bool is_good() const
+            {
+                return (nullptr != ptr_ ? true : false);
+            }
+
+            void* get() const
+            {
+                return ptr_;
+            }
+
+            std::size_t size() const
+            {
+                return size_;
+            }
+
+        private:
+            void* ptr_;
+            const std::size_t size_;
+        };
+
+        // ===================================================================
+        // Heap for memory shared by processes. The heap is placed at the start
+        // of the region and links its pages by offsets, so every process may
+        // map the region at a different address
+        // ===================================================================
+        class shm_heap
+        {
+        public:
+            using offset_t = std::uint32_t;
+
+            static constexpr offset_t null_offset = 0u;
+
+            shm_heap(const shm_heap&)              = delete;
+            shm_heap(shm_heap&&)                   = delete;
+
+            shm_heap& operator = (const shm_heap&) = delete;
+            shm_heap& operator = (shm_heap&&)      = delete;
+
+            static shm_heap* create(void* region, std::size_t size);
+            static shm_heap* attach(void* region);
+
+            void* alloc(offset_t size);
+            void free(void *p);
+            void free(void *p, offset_t size);
+
+            std::uint32_t free_size() const
+            {
+                return free_size_;
+            }
+
+            offset_t to_offset(const void* p) const
+            {
+                return (nullptr != p) ? static_cast<offset_t>(static_cast<const std::uint8_t*>(p) - base()) : null_offset;
+            }
+
+            template <typename T = void>
+            T* from_offset(offset_t off) const
+            {
+                return (null_offset != off) ? reinterpret_cast<T*>(const_cast<std::uint8_t*>(base()) + off) : nullptr;
+            }
+
+            // The root is an offset stored in the heap itself, e.g. of a structure
+            // by which processes find each other's data after attaching
+            void set_root(offset_t off)
+            {
+                root_ = off;
+            }
+
+            offset_t get_root() const
+            {
+                return root_;
+            }
+
+        private:
+
+            shm_heap()
+            {}
+
+            struct page_t
+            {
+                offset_t size;
+                offset_t prev;
+                bool free;
+            };
+
+            static constexpr std::uint32_t magic_value_ = 0x43454C48u;
+            static constexpr offset_t heap_align_ = alignof(std::max_align_t);
+
+            static constexpr offset_t align_size(offset_t size)
+            {
+                return (size + (heap_align_ - 1u)) & ~(heap_align_ - 1u);
+            }
+
+            static constexpr offset_t page_size_ = (sizeof(page_t) + (heap_align_ - 1u)) & ~(heap_align_ - 1u);
+
+            bool lock();
+            void unlock();
+            bool recover();
+
+            void* alloc_locked(offset_t size);
+            void coalesce(page_t * const pg);
+            page_t* page_at(offset_t off) const;
+            page_t* page_of(void *p) const;
+            page_t* next_page(page_t * const pg) const;
+
+            const std::uint8_t* base() const
+            {
+                return reinterpret_cast<const std::uint8_t*>(this);
+            }
+
+            pthread_mutex_t mutex_;
+            std::atomic<std::uint32_t> magic_;
+            offset_t heap_start_;
+            offset_t heap_end_;
+            std::uint32_t free_size_;
+            offset_t root_;
+        };
+
+        // ===================================================================
+        // Ring buffer allocator class placing the storage in mirror_region,
+        // so that any run of elements is contiguous in memory, e.g. reserve
+        // and peek return a single part. The storage size must be a multiple
+        // of the page size, otherwise the ring is not good
+        // ===================================================================
+        template <typename T, typename engine_t = ring_spsc>
+        class mirrored_ring_allocator
+        {
+            static_assert(detail::storage_size<engine_t, T>(8u) == (8u * sizeof(T)), "Mirroring requires contiguous elements without extra storage");
+
+        public:
+            using engine = engine_t;
+
+            static constexpr bool mirrored = true;
+
+            mirrored_ring_allocator(const mirrored_ring_allocator&)              = delete;
+            mirrored_ring_allocator(mirrored_ring_allocator&&)                   = delete;
+
+            mirrored_ring_allocator& operator = (const mirrored_ring_allocator&) = delete;
+            mirrored_ring_allocator& operator = (mirrored_ring_allocator&&)      = delete;
+
+            mirrored_ring_allocator(ring_base::span_t sz, bool infinite = false) :
+                                        region_(detail::storage_size<engine, T>(sz)),
+                                        info_(static_cast<std::uint8_t*>(region_.get()), sz, sizeof(T), infinite, sizeof(T))
+            {
+            }
+
+        private:
+
+            mirror_region region_;
+
+        protected:
+
+            typename engine::ring_info info_;
+        };
+
+        // ===================================================================
+        // Notification of consumers parked on a ring. The producer signals
+        // after every push, but issues the futex wake or eventfd write only
+        // while consumers are parked, so that the fast path stays free of
+        // system calls
+        // ===================================================================
+        class ring_event
+        {
+        public:
+            ring_event(const ring_event&)              = delete;
+            ring_event(ring_event&&)                   = delete;
+
+            ring_event& operator = (const ring_event&) = delete;
+            ring_event& operator = (ring_event&&)      = delete;
+
+            // With b_eventfd the consumers are woken through an eventfd
+            // which can also be polled, e.g. by epoll
+            explicit ring_event(bool b_eventfd = false);
+
+            ~ring_event();
+
+            // Called by producer after making elements available
+            void notify();
+
+            // Called by consumer before checking the ring for the last time, parks
+            // the consumer till wait or cancel. The returned value is passed to wait
+            std::uint32_t prepare();
+
+            // Puts the consumer to sleep till notified or till timeout in milliseconds
+            // elapses, a negative timeout waits forever. Returns false on timeout
+            bool wait(std::uint32_t seq, int timeout_ms);
+
+            // Called by consumer which does not call wait after prepare, e.g. found
+            // an element or has polled the eventfd itself
+            void cancel();
+
+            int get_fd() const
+            {
+                return fd_;
+            }
+
+        private:
+            std::atomic<std::uint32_t> seq_;
+            std::atomic<std::uint32_t> parked_;
+            const int fd_;
+        };
+
+        // ===================================================================
+        // Ring buffer whose consumer can wait for elements. The ring must be
+        // thread safe, i.e. use ring_spsc or ring_mpmc, as masking of
+        // interrupts does not protect rings on POSIX targets. The maker is
+        // a private base, so that every push goes through notify
+        // ===================================================================
+        template <typename T, typename allocator = ring_heap_allocator<T, ring_spsc>, bool b_eventfd = false>
+        class waitable_ring : private ring_maker<T, allocator>
+        {
+            using maker = ring_maker<T, allocator>;
+
+        public:
+            using maker::in_place;
+            using maker::is_good;
+            using maker::get_count;
+            using maker::get_size;
+            using maker::is_infinite;
+            using maker::reset;
+            using maker::pop;
+            using maker::pop_n;
+            using maker::reserve;
+            using maker::peek;
+            using maker::consume;
+            using maker::peek_at;
+            using typename maker::const_iterator;
+            using maker::begin;
+            using maker::end;
+            using maker::read_shadow;
+            using maker::read_shadow_ptr;
+
+            waitable_ring(const waitable_ring&)              = delete;
+            waitable_ring(waitable_ring&&)                   = delete;
+
+            waitable_ring& operator = (const waitable_ring&) = delete;
+            waitable_ring& operator = (waitable_ring&&)      = delete;
+
+            template <typename... Args>
+            explicit waitable_ring(Args&&... args) : maker(std::forward<Args>(args)...), event_(b_eventfd)
+            {
+            }
+
+            bool push(const T& t)
+            {
+                const bool retval = maker::push(t);
+
+                if (retval)
+                {
+                    event_.notify();
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return retval;
+            }
+
+            ring_base::span_t push_n(const T* ptr, ring_base::span_t count)
+            {
+                const ring_base::span_t m = maker::push_n(ptr, count);
+
+                if (m > 0u)
+                {
+                    event_.notify();
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return m;
+            }
+
+            ring_base::span_t commit(ring_base::span_t count)
+            {
+                const ring_base::span_t m = maker::commit(count);
+
+                if (m > 0u)
+                {
+                    event_.notify();
+                }
+                else
+                {
+                    // do nothing
+                }
+
+                return m;
+            }
+
+            // Pops the oldest element, waiting up to timeout_ms milliseconds for it,
+            // a negative timeout waits forever
+            bool pop_wait(T& t, int timeout_ms = -1)
+            {
+                bool retval = maker::pop(t);
+                bool b_waiting = !retval;
+
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+
+                while (b_waiting)
+                {
+                    const std::uint32_t seq = event_.prepare();
+
+                    retval = maker::pop(t);
+                    if ( !retval )
+                    {
+                        int remaining_ms = timeout_ms;
+                        if (timeout_ms >= 0)
+                        {
+                            // the consumer may be woken for an element taken by another one
+                            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                            remaining_ms = (left.count() > 0) ? static_cast<int>(left.count()) : 0;
+                        }
+                        else
+                        {
+                            // do nothing
+                        }
+
+                        b_waiting = event_.wait(seq, remaining_ms);
+                        retval = maker::pop(t);
+                    }
+                    else
+                    {
+                        event_.cancel();
+                    }
+
+                    b_waiting = b_waiting && !retval;
+                }
+
+                return retval;
+            }
+
+            // Event to be used by consumers polling the ring, e.g. with epoll
+            ring_event& event()
+            {
+                return event_;
+            }
+
+        private:
+            ring_event event_;
+        };
+
+        // ===================================================================
+        // Transfer between rings of bytes and file descriptors, e.g. sockets
+        // or log files. The (at most two) parts of the ring are passed to a
+        // single writev or readv, so the bytes are copied by the kernel only
+        // ===================================================================
+
+        // Writes the parts of reg with one writev, returns the number of bytes
+        // written or -1 with errno set
+        ssize_t write_region(int fd, const ring_region<const std::uint8_t>& reg);
+
+        // Reads into the parts of reg with one readv, returns the number of bytes
+        // read, 0 on end of file or -1 with errno set
+        ssize_t read_region(int fd, const ring_region<std::uint8_t>& reg);
+
+        // Writes as many bytes of the ring to fd as it accepts and removes them
+        // from the ring. Must be called by consumer, the ring must provide peek
+        // and consume, e.g. ring_spsc. Returns 0 without a system call if the
+        // ring is empty
+        template <typename ring_t>
+        ssize_t drain_to_fd(ring_t& ring, int fd)
+        {
+            static_assert(ring_t::in_place, "drain_to_fd needs a ring class providing peek and consume, e.g. ring_spsc");
+
+            const auto reg = ring.peek(static_cast<ring_base::span_t>(~0u));
+
+            static_assert(1u == sizeof(*reg.ptr[0]), "Partly written elements could not be consumed, the ring must hold bytes");
+
+            ssize_t n = 0;
+
+            if (reg.size() > 0u)
+            {
+                n = write_region(fd, { { reinterpret_cast<const std::uint8_t*>(reg.ptr[0]), reinterpret_cast<const std::uint8_t*>(reg.ptr[1]) },
+                                       { reg.count[0], reg.count[1] } });
+                if (n > 0)
+                {
+                    (void)ring.consume(static_cast<ring_base::span_t>(n));
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return n;
+        }
+
+        // Returned by fill_from_fd without a system call if the ring is full
+        constexpr ssize_t ring_full = -2;
+
+        // Reads from fd as many bytes as the ring has space for and makes them
+        // visible to the consumer. Must be called by producer, the ring must
+        // provide reserve and commit, e.g. ring_spsc. Returns the number of
+        // bytes read, 0 on end of file, -1 with errno set, e.g. to EAGAIN if a
+        // non-blocking descriptor has no data, or ring_full with errno intact
+        template <typename ring_t>
+        ssize_t fill_from_fd(ring_t& ring, int fd)
+        {
+            static_assert(ring_t::in_place, "fill_from_fd needs a ring class providing reserve and commit, e.g. ring_spsc");
+
+            const auto reg = ring.reserve(static_cast<ring_base::span_t>(~0u));
+
+            static_assert(1u == sizeof(*reg.ptr[0]), "Partly read elements could not be committed, the ring must hold bytes");
+
+            ssize_t n = ring_full;
+
+            if (reg.size() > 0u)
+            {
+                n = read_region(fd, { { reinterpret_cast<std::uint8_t*>(reg.ptr[0]), reinterpret_cast<std::uint8_t*>(reg.ptr[1]) },
+                                      { reg.count[0], reg.count[1] } });
+                if (n > 0)
+                {
+                    (void)ring.commit(static_cast<ring_base::span_t>(n));
+                }
+                else
+                {
+                    // do nothing
+                }
+            }
+            else
+            {
+                // do nothing
+            }
+
+            return n;
+        }
+    }
+}
+
+#endif // CPP_EMB_LIB_POSIX_HPP_INCLUDED
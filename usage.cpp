@@ -183,5 +183,19 @@ namespace cel
 
         // We can reset the FIFO to start from clean buffer
         cmd_ring.reset();
+
+        // [[[[   Case 5   ]]]]
+        // Construct a cmd_t object in the static heap. Unlike auto_heap, the ownership
+        // of the object can be moved to another heap_ptr without copying the object
+        buffer::heap_ptr<cmd_t> ptr_owner = buffer::make_heap<cmd_t>(cmd);
+
+        if ( ptr_owner )
+        {
+            buffer::heap_ptr<cmd_t> ptr_next = std::move(ptr_owner);
+
+            // ptr_owner is empty now, the object is destroyed and released
+            // when ptr_next leaves the scope
+            ptr_next->m_u32 = 0u;
+        }
     }
 }